@@ -0,0 +1,177 @@
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "account_manager.h"
+#include "error_handler.h"
+#include "latency_histogram.h"
+#include "load_worker.h"
+#include "lock_monitor.h"
+#include "logger.h"
+#include "system_call_interface.h"
+#include "transaction_client.h"
+
+using namespace std;
+
+void print_latency(const string& label, const LatencyHistogram& histogram) {
+    auto us = [](uint64_t ns) { return ns / 1000.0; };
+    cout << fixed << setprecision(1) << label << " (us): mean=" << us(static_cast<uint64_t>(histogram.mean()))
+         << " p50=" << us(histogram.percentile(50)) << " p90=" << us(histogram.percentile(90))
+         << " p99=" << us(histogram.percentile(99)) << " p99.9=" << us(histogram.percentile(99.9))
+         << " max=" << us(histogram.maximum()) << endl;
+    cout.unsetf(ios::floatfield);
+}
+
+// Load generator against the in-process system call interface or a running
+// transaction server. In-process runs can profile lock contention with
+// --lock-profile, writing the report to PATH (- for stdout).
+// Usage: banking_loadgen [--target inproc|tcp|unix] [--port N] [--unix PATH]
+//                        [--threads N] [--accounts N] [--duration S] [--rate OPS]
+//                        [--loop closed|open] [--dist uniform|zipf|hotset]
+//                        [--zipf-theta T] [--hot-fraction F] [--hot-probability P]
+//                        [--mix DEPOSIT:WITHDRAW:BALANCE:TRANSFER] [--log-sample N]
+//                        [--lock-profile PATH]
+int main(int argc, char* argv[]) {
+    LoadOptions options;
+    uint32_t log_sampling = 1;
+    string lock_profile_path;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string option = argv[i];
+        string value = argv[i + 1];
+        if (option == "--target") {
+            options.target = value;
+        }
+        else if (option == "--port") {
+            options.port = static_cast<uint16_t>(stoi(value));
+        }
+        else if (option == "--unix") {
+            options.unix_path = value;
+        }
+        else if (option == "--threads") {
+            options.threads = max<size_t>(1, stoul(value));
+        }
+        else if (option == "--accounts") {
+            options.accounts = max<size_t>(2, stoul(value));
+        }
+        else if (option == "--duration") {
+            options.duration_s = stod(value);
+        }
+        else if (option == "--rate") {
+            options.rate = stod(value);
+        }
+        else if (option == "--loop") {
+            options.open_loop = value == "open";
+        }
+        else if (option == "--dist") {
+            options.distribution = value == "zipf" ? KeyGenerator::Zipfian : value == "hotset" ? KeyGenerator::HotSet : KeyGenerator::Uniform;
+        }
+        else if (option == "--zipf-theta") {
+            options.zipf_theta = stod(value);
+        }
+        else if (option == "--hot-fraction") {
+            options.hot_fraction = stod(value);
+        }
+        else if (option == "--hot-probability") {
+            options.hot_probability = stod(value);
+        }
+        else if (option == "--mix") {
+            stringstream weights(value);
+            string weight;
+            for (int w = 0; w < 4 && getline(weights, weight, ':'); ++w) {
+                options.mix[w] = stod(weight);
+            }
+        }
+        else if (option == "--log-sample") {
+            log_sampling = static_cast<uint32_t>(stoul(value));
+        }
+        else if (option == "--lock-profile") {
+            lock_profile_path = value;
+        }
+        else {
+            cerr << "Unknown option: " << option << endl;
+            return 1;
+        }
+    }
+    if (options.open_loop && options.rate <= 0) {
+        cerr << "Open-loop load needs a target --rate" << endl;
+        return 1;
+    }
+
+    vector<LoadWorkerResult> results(options.threads);
+    vector<thread> workers;
+    vector<int> account_ids;
+    auto start = chrono::steady_clock::now();
+
+    if (options.target == "inproc") {
+        Logger logger;
+        logger.set_sampling(LogCategory::Transaction, log_sampling);
+        LockMonitor::set_logger(&logger);
+        AccountManager accountManager(logger);
+        ErrorHandler errorHandler(logger);
+        SystemCallInterface sysCallInterface(accountManager, errorHandler);
+        for (size_t i = 0; i < options.accounts; ++i) {
+            account_ids.push_back(sysCallInterface.create_account(static_cast<int>(i % 1000) + 1, 1e6f));
+        }
+        start = chrono::steady_clock::now();
+        LockMonitor::set_profiling(!lock_profile_path.empty());
+        for (size_t w = 0; w < options.threads; ++w) {
+            workers.emplace_back([&, w] { run_load_worker(sysCallInterface, options, account_ids, w, start, results[w]); });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        LockMonitor::set_profiling(false);
+        LockMonitor::set_logger(nullptr);
+    }
+    else {
+        // One connection per worker, as separate client processes would have
+        vector<unique_ptr<TransactionClient>> clients;
+        for (size_t w = 0; w < options.threads; ++w) {
+            auto client = make_unique<TransactionClient>();
+            bool connected = options.target == "unix" ? client->connect_unix(options.unix_path) : client->connect_tcp(options.port);
+            if (!connected) {
+                cerr << "Failed to connect to the transaction server (" << options.target << ")" << endl;
+                return 1;
+            }
+            clients.push_back(move(client));
+        }
+        for (size_t i = 0; i < options.accounts; ++i) {
+            account_ids.push_back(clients[0]->create_account(static_cast<int>(i % 1000) + 1, 1e6f));
+        }
+        start = chrono::steady_clock::now();
+        for (size_t w = 0; w < options.threads; ++w) {
+            workers.emplace_back([&, w] { run_load_worker(*clients[w], options, account_ids, w, start, results[w]); });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    LoadWorkerResult total;
+    for (const auto& result : results) {
+        total.latency.merge(result.latency);
+        total.service_time.merge(result.service_time);
+        total.operations += result.operations;
+        total.failures += result.failures;
+    }
+    cout << "Load: target=" << options.target << " loop=" << (options.open_loop ? "open" : "closed")
+         << " threads=" << options.threads << " accounts=" << options.accounts
+         << " rate=" << (options.rate > 0 ? to_string(static_cast<long long>(options.rate)) + " ops/s" : "unlimited") << endl;
+    cout << "Throughput: " << total.operations << " ops in " << setprecision(3) << elapsed << " s = "
+         << static_cast<long long>(total.operations / elapsed) << " ops/s (" << total.failures << " failed)" << endl;
+    print_latency("Latency", total.latency);
+    print_latency("Service time", total.service_time);
+    if (lock_profile_path == "-") {
+        cout << LockMonitor::contention_report();
+    }
+    else if (!lock_profile_path.empty()) {
+        ofstream(lock_profile_path) << LockMonitor::contention_report();
+    }
+    return 0;
+}
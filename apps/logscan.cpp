@@ -0,0 +1,139 @@
+#include <charconv>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "log_verifier.h"
+#include "mapped_log.h"
+
+using namespace std;
+
+// Per-worker reconciliation totals, merged after the scan
+struct ScanTotals {
+    map<string, uint64_t, less<>> records_by_type;
+    uint64_t records = 0;
+    uint64_t bytes = 0;
+    double deposited = 0.0;
+    double withdrawn = 0.0;
+    double transferred = 0.0;
+
+    void add(string_view record) {
+        ++records;
+        bytes += record.size() + 1;
+        size_t body = record.find("] ");
+        body = body == string_view::npos ? 0 : body + 2;
+        size_t colon = record.find(':', body);
+        string_view type = colon == string_view::npos ? string_view("Other") : record.substr(body, colon - body);
+        auto it = records_by_type.find(type);
+        if (it == records_by_type.end()) {
+            it = records_by_type.emplace(string(type), 0).first;
+        }
+        ++it->second;
+
+        size_t amount_pos = record.find("Amount=");
+        if (amount_pos == string_view::npos) {
+            return;
+        }
+        double amount = 0.0;
+        const char* first = record.data() + amount_pos + 7;
+        from_chars(first, record.data() + record.size(), amount);
+        if (type == "Deposit") {
+            deposited += amount;
+        }
+        else if (type == "Withdrawal") {
+            withdrawn += amount;
+        }
+        else if (type == "Transfer") {
+            transferred += amount;
+        }
+    }
+
+    void merge(const ScanTotals& other) {
+        for (const auto& [type, count] : other.records_by_type) {
+            records_by_type[type] += count;
+        }
+        records += other.records;
+        bytes += other.bytes;
+        deposited += other.deposited;
+        withdrawn += other.withdrawn;
+        transferred += other.transferred;
+    }
+};
+
+// Check the log's hash chain and checkpoints; exit status 2 if tampered
+int verify_log(const string& log_path, size_t threads, bool incremental) {
+    LogVerifier verifier(log_path);
+    auto start = chrono::steady_clock::now();
+    LogVerifyResult result = incremental ? verifier.verify_incremental(threads) : verifier.verify(threads);
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << (incremental ? "Incremental" : "Full") << " verification of " << log_path << ": "
+         << (result.ok ? "OK" : "FAILED") << endl;
+    cout << "  " << result.checkpoints << " checkpoint(s), " << result.records << " record(s) + " << result.tail_records
+         << " unclosed in " << fixed << setprecision(3) << elapsed << " s with " << threads << " thread(s)" << endl;
+    if (!result.ok) {
+        cout << "  " << result.error << endl;
+        return 2;
+    }
+    return 0;
+}
+
+// Scan every segment of a transaction log in parallel and print per-type
+// record counts and money-flow totals for reconciliation, or verify that the
+// log has not been modified.
+// Usage: banking_logscan [--log PATH] [--threads N] [--verify full|incremental]
+int main(int argc, char* argv[]) {
+    string log_path = "transactions.log";
+    size_t threads = max(1u, thread::hardware_concurrency());
+    string verify_mode;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string option = argv[i];
+        if (option == "--log") {
+            log_path = argv[i + 1];
+        }
+        else if (option == "--threads") {
+            threads = max<size_t>(1, stoul(argv[i + 1]));
+        }
+        else if (option == "--verify") {
+            verify_mode = argv[i + 1];
+            if (verify_mode != "full" && verify_mode != "incremental") {
+                cerr << "--verify takes full or incremental" << endl;
+                return 1;
+            }
+        }
+        else {
+            cerr << "Unknown option: " << option << endl;
+            return 1;
+        }
+    }
+
+    if (!verify_mode.empty()) {
+        return verify_log(log_path, threads, verify_mode == "incremental");
+    }
+
+    MappedLogReader reader(log_path);
+    vector<ScanTotals> per_worker(threads);
+    auto start = chrono::steady_clock::now();
+    reader.parallel_scan(threads, [&](size_t worker, string_view record) { per_worker[worker].add(record); });
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    ScanTotals total;
+    for (const auto& totals : per_worker) {
+        total.merge(totals);
+    }
+
+    cout << "Scanned " << total.records << " records (" << total.bytes << " bytes) in " << reader.segment_count()
+         << " segment(s) with " << threads << " thread(s) in " << fixed << setprecision(3) << elapsed << " s = "
+         << setprecision(1) << (elapsed > 0 ? total.bytes / elapsed / 1e6 : 0.0) << " MB/s" << endl;
+    for (const auto& [type, count] : total.records_by_type) {
+        cout << "  " << type << ": " << count << endl;
+    }
+    cout << setprecision(2) << "Deposited=" << total.deposited << " Withdrawn=" << total.withdrawn
+         << " Transferred=" << total.transferred << endl;
+    return 0;
+}
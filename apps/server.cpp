@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <cmath>
+#include <csignal>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <pthread.h>
+
+#include "account_manager.h"
+#include "error_handler.h"
+#include "lock_monitor.h"
+#include "logger.h"
+#include "system_call_interface.h"
+#include "transaction_server.h"
+
+using namespace std;
+
+// Serve the system call interface to other processes until SIGINT/SIGTERM.
+// With --lock-profile, lock contention is profiled and the report written to
+// PATH (- for stdout) on shutdown. --customer-rate and --account-rate limit
+// the calls per second of each customer and each account; the rejected
+// counts are printed on shutdown.
+// Usage: banking_server [--port N] [--unix PATH] [--loops N] [--log-sample N] [--lock-profile PATH]
+//                       [--customer-rate R] [--account-rate R]
+int main(int argc, char* argv[]) {
+    int port = 7070;
+    string unix_path;
+    size_t num_loops = max(1u, thread::hardware_concurrency());
+    uint32_t log_sampling = 1;
+    string lock_profile_path;
+    RateLimitPolicy rate_limit_policy;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string option = argv[i];
+        if (option == "--port") {
+            port = stoi(argv[i + 1]);
+        }
+        else if (option == "--unix") {
+            unix_path = argv[i + 1];
+        }
+        else if (option == "--loops") {
+            num_loops = stoul(argv[i + 1]);
+        }
+        else if (option == "--log-sample") {
+            log_sampling = static_cast<uint32_t>(stoul(argv[i + 1]));
+        }
+        else if (option == "--lock-profile") {
+            lock_profile_path = argv[i + 1];
+        }
+        else if (option == "--customer-rate" || option == "--account-rate") {
+            // stod() accepts "nan" and "inf"
+            double rate = stod(argv[i + 1]);
+            if (!isfinite(rate) || rate < 0) {
+                cerr << option << " must be a finite, non-negative number of calls per second" << endl;
+                return 1;
+            }
+            (option == "--customer-rate" ? rate_limit_policy.customer_rate : rate_limit_policy.account_rate) = rate;
+        }
+        else {
+            cerr << "Unknown option: " << option << endl;
+            return 1;
+        }
+    }
+
+    Logger logger;
+    logger.set_sampling(LogCategory::Transaction, log_sampling);
+    LockMonitor::set_logger(&logger);
+    LockMonitor::set_profiling(!lock_profile_path.empty());
+    AccountManager accountManager(logger);
+    ErrorHandler errorHandler(logger);
+    SystemCallInterface sysCallInterface(accountManager, errorHandler, nullptr, {}, rate_limit_policy);
+    TransactionServer server(sysCallInterface, errorHandler);
+
+    // Block shutdown signals in every thread; the main thread waits for them below
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    if (port >= 0 && !server.listen_tcp(static_cast<uint16_t>(port))) {
+        cerr << "Failed to listen on TCP port " << port << endl;
+        return 1;
+    }
+    if (!unix_path.empty() && !server.listen_unix(unix_path)) {
+        cerr << "Failed to listen on " << unix_path << endl;
+        return 1;
+    }
+    if (!server.start(num_loops)) {
+        return 1;
+    }
+    cout << "Transaction server listening";
+    if (port >= 0) {
+        cout << " on 127.0.0.1:" << server.port();
+    }
+    if (!unix_path.empty()) {
+        cout << " on " << unix_path;
+    }
+    cout << " with " << num_loops << " event loop(s)" << endl;
+
+    int signal_number = 0;
+    sigwait(&signals, &signal_number);
+    server.stop();
+    if (rate_limit_policy.customer_rate > 0 || rate_limit_policy.account_rate > 0) {
+        RateLimitMetrics metrics = sysCallInterface.rate_limit_metrics();
+        cout << "Rate limited: customers=" << metrics.customer_rejected << " accounts=" << metrics.account_rejected
+             << " overflowed=" << metrics.overflowed << endl;
+    }
+    if (lock_profile_path == "-") {
+        cout << LockMonitor::contention_report();
+    }
+    else if (!lock_profile_path.empty()) {
+        ofstream(lock_profile_path) << LockMonitor::contention_report();
+    }
+    LockMonitor::set_logger(nullptr);
+    return 0;
+}
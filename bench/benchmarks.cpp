@@ -0,0 +1,484 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "account_manager.h"
+#include "ipc_manager.h"
+#include "lock_monitor.h"
+#include "log_chain.h"
+#include "log_segments.h"
+#include "log_verifier.h"
+#include "logger.h"
+#include "mapped_log.h"
+#include "memory_manager.h"
+#include "microbench.h"
+#include "process_manager.h"
+#include "scheduler.h"
+#include "system_call_interface.h"
+
+using namespace std;
+
+// Fixtures for the manager benchmarks; `arg` is the data size of the run
+struct AccountFixture {
+    Logger logger;
+    AccountManager accountManager;
+    vector<int> account_ids;
+
+    AccountFixture(int64_t accounts) : accountManager(logger) {
+        for (int64_t i = 0; i < accounts; ++i) {
+            account_ids.push_back(accountManager.add_account(static_cast<int>(i % 1000), 1e9f));
+        }
+    }
+};
+
+// One settlement account taking every deposit; `arg` enables hot account
+// promotion. Success records are filtered out to leave the account path.
+struct HotAccountFixture {
+    Logger logger;
+    AccountManager accountManager;
+    int account_id;
+
+    HotAccountFixture(int64_t hot) : accountManager(logger, {}, HotAccountPolicy{ hot != 0 }) {
+        logger.set_level(LogCategory::Transaction, LogLevel::Warning);
+        account_id = accountManager.add_account(1, 0.0f);
+    }
+};
+
+// Deposits through the syscall layer; `arg` is the idempotency key use:
+// 0 none, 1 a new key per call, 2 retries of already completed keys
+struct SyscallFixture {
+    static constexpr int ACCOUNTS = 1000;
+    static constexpr uint64_t RETRIED_KEYS = 4096;
+
+    Logger logger;
+    AccountManager accountManager;
+    ErrorHandler errorHandler;
+    SystemCallInterface sysCallInterface;
+    vector<int> account_ids;
+
+    SyscallFixture(int64_t) : accountManager(logger), errorHandler(logger), sysCallInterface(accountManager, errorHandler) {
+        logger.set_level(LogCategory::Transaction, LogLevel::Warning);
+        for (int i = 0; i < ACCOUNTS; ++i) {
+            account_ids.push_back(accountManager.add_account(i, 1e9f));
+        }
+        for (uint64_t key = 1; key <= RETRIED_KEYS; ++key) {
+            sysCallInterface.deposit(retried_account(key), 1.0f, key);
+        }
+    }
+
+    int retried_account(uint64_t key) const { return account_ids[key % ACCOUNTS]; }
+};
+
+// Deposits through the syscall layer with per-customer and per-account
+// limits when `arg` is set, high enough that every call is admitted
+struct RateLimitFixture {
+    Logger logger;
+    AccountManager accountManager;
+    ErrorHandler errorHandler;
+    SystemCallInterface sysCallInterface;
+    vector<int> account_ids;
+
+    static RateLimitPolicy policy(int64_t limited) {
+        RateLimitPolicy policy;
+        if (limited != 0) {
+            policy.customer_rate = 1e12;
+            policy.account_rate = 1e12;
+        }
+        return policy;
+    }
+
+    RateLimitFixture(int64_t limited)
+        : accountManager(logger), errorHandler(logger), sysCallInterface(accountManager, errorHandler, nullptr, {}, policy(limited)) {
+        logger.set_level(LogCategory::Transaction, LogLevel::Warning);
+        for (int i = 0; i < 1000; ++i) {
+            account_ids.push_back(accountManager.add_account(i % 100, 1e9f));
+        }
+    }
+};
+
+struct LoggerFixture {
+    Logger logger;
+    string message;
+
+    LoggerFixture(int64_t message_size) : message(static_cast<size_t>(message_size), 'x') {}
+};
+
+// A plain transaction log of `records` records to scan
+struct LogScanFixture {
+    string path;
+
+    LogScanFixture(int64_t records) : path("scan_" + to_string(records) + ".log") {
+        ofstream out(path, ios::trunc);
+        for (int64_t i = 0; i < records; ++i) {
+            out << "[Sat Oct 17 06:22:33.902147 2026] Deposit: Account ID=" << i % 1000 << ", Amount=" << i << ".000000\n";
+        }
+    }
+};
+
+// The transaction writer's per-record work, with (`sealed` = 1) or without
+// the hash chain
+struct ChainFixture {
+    SegmentedLog log;
+    LogChain chain;
+
+    ChainFixture(int64_t sealed)
+        : log("chain_" + to_string(sealed) + ".log", LogRotationPolicy{ 0, chrono::seconds(0), false }),
+          chain(log, LogIntegrityPolicy{ sealed != 0 }) {}
+};
+
+// A hash-chained log of `records` records with its checkpoints
+struct SealedLogFixture {
+    string path;
+
+    SealedLogFixture(int64_t records) : path("sealed_" + to_string(records) + ".log") {
+        SegmentedLog log(path, LogRotationPolicy{ 0, chrono::seconds(0), false });
+        LogChain chain(log);
+        LogLine line;
+        for (int64_t i = 0; i < records; ++i) {
+            line.clear();
+            line.append_all("[Sat Oct 17 06:22:33.902147 2026] Deposit: Account ID=", i % 1000, ", Amount=", i, ".000000");
+            chain.seal(line);
+            log.append(line.data(), line.size());
+            chain.after_append();
+        }
+        chain.checkpoint();
+    }
+};
+
+struct ProcessFixture {
+    ProcessManager processManager;
+    Scheduler scheduler;
+
+    ProcessFixture(int64_t) : scheduler(processManager, 0) {}
+};
+
+struct MemoryFixture {
+    MemoryManager memoryManager;
+
+    MemoryFixture(int64_t pages) : memoryManager(static_cast<size_t>(pages)) {
+        for (int64_t i = 0; i < pages; ++i) {
+            memoryManager.store_data_in_page(static_cast<int>(i), 0.0f);
+        }
+    }
+};
+
+// A plain mutex and a deadlock-monitored one guarding a counter; `arg`
+// turns on contention profiling
+struct LockFixture {
+    mutex plain;
+    MonitoredMutex monitored{ "LockFixture" };
+    int64_t counter = 0;
+
+    LockFixture(int64_t profiled) { LockMonitor::set_profiling(profiled != 0); }
+    ~LockFixture() { LockMonitor::set_profiling(false); }
+};
+
+struct IPCFixture {
+    IPCManager ipcManager;
+    vector<int> subscriber_ids;
+
+    IPCFixture(int64_t subscribers) {
+        for (int64_t i = 0; i < subscribers; ++i) {
+            subscriber_ids.push_back(ipcManager.subscribe(IPCManager::event_topic("deposit")));
+        }
+    }
+};
+
+void register_benchmarks(BenchmarkRegistry& registry) {
+    // Logger: one record per operation, by message size
+    registry.add<LoggerFixture>("Logger/log_transaction", { 16, 128, 1024 }, true, [](LoggerFixture& f, BenchState& state) {
+        for (auto _ : state) {
+            f.logger.log_transaction(f.message);
+        }
+    });
+    registry.add<LoggerFixture>("Logger/log_error", { 16, 128 }, true, [](LoggerFixture& f, BenchState& state) {
+        for (auto _ : state) {
+            f.logger.log_error(f.message);
+        }
+    });
+    registry.add<LoggerFixture>("Logger/log_transaction_fields", { 0 }, true, [](LoggerFixture& f, BenchState& state) {
+        int account_id = state.thread_index;
+        for (auto _ : state) {
+            f.logger.log_transaction("Deposit: Account ID=", account_id, ", Amount=", 125.5f);
+        }
+    });
+    // Leveled success event kept 1 in `arg` times
+    registry.add<LoggerFixture>("Logger/log_info_sampled", { 1, 16, 1024 }, true, [](LoggerFixture& f, BenchState& state) {
+        f.logger.set_sampling(LogCategory::Transaction, static_cast<uint32_t>(state.arg));
+        int account_id = state.thread_index;
+        for (auto _ : state) {
+            f.logger.log<LogLevel::Info>(LogCategory::Transaction, "Deposit: Account ID=", account_id, ", Amount=", 125.5f);
+        }
+    });
+
+    // Log writer: format, seal and append one record, unsealed (0) vs sealed (1)
+    registry.add<ChainFixture>("LogChain/seal_append", { 0, 1 }, false, [](ChainFixture& f, BenchState& state) {
+        LogLine line;
+        int64_t i = 0;
+        for (auto _ : state) {
+            line.clear();
+            line.append_all("[Sat Oct 17 06:22:33.902147 2026] Deposit: Account ID=", i % 1000, ", Amount=", i, ".000000");
+            f.chain.seal(line);
+            f.log.append(line.data(), line.size());
+            f.chain.after_append();
+            ++i;
+        }
+    });
+
+    // Audit: full parallel verification of a sealed `arg`-record log, and an
+    // incremental one with nothing new since the last run
+    registry.add<SealedLogFixture>("LogVerify/full", { 1000000 }, false, [](SealedLogFixture& f, BenchState& state) {
+        size_t threads = max(1u, thread::hardware_concurrency());
+        for (auto _ : state) {
+            LogVerifier verifier(f.path);
+            do_not_optimize(verifier.verify(threads).ok);
+        }
+    });
+    registry.add<SealedLogFixture>("LogVerify/incremental", { 1000000 }, false, [](SealedLogFixture& f, BenchState& state) {
+        size_t threads = max(1u, thread::hardware_concurrency());
+        LogVerifier verifier(f.path);
+        verifier.verify_incremental(threads);
+        for (auto _ : state) {
+            do_not_optimize(verifier.verify_incremental(threads).ok);
+        }
+    });
+
+    // Log replay: full scan of a `arg`-record log, counting record bytes
+    registry.add<LogScanFixture>("LogScan/LogReader", { 1000000 }, false, [](LogScanFixture& f, BenchState& state) {
+        for (auto _ : state) {
+            LogReader reader(vector<string>{ f.path });
+            string line;
+            size_t bytes = 0;
+            while (reader.next(line)) {
+                bytes += line.size();
+            }
+            do_not_optimize(bytes);
+        }
+    });
+    registry.add<LogScanFixture>("LogScan/MappedLogReader", { 1000000 }, false, [](LogScanFixture& f, BenchState& state) {
+        for (auto _ : state) {
+            MappedLogReader reader(f.path);
+            size_t bytes = 0;
+            reader.scan([&](string_view record) { bytes += record.size(); });
+            do_not_optimize(bytes);
+        }
+    });
+    registry.add<LogScanFixture>("LogScan/MappedLogReader_parallel", { 1000000 }, false, [](LogScanFixture& f, BenchState& state) {
+        size_t threads = max(1u, thread::hardware_concurrency());
+        vector<size_t> bytes(threads);
+        for (auto _ : state) {
+            MappedLogReader reader(f.path);
+            reader.parallel_scan(threads, [&](size_t worker, string_view record) { bytes[worker] += record.size(); });
+            do_not_optimize(bytes.data());
+        }
+    });
+
+    // AccountManager: hot methods over a book of `arg` accounts
+    registry.add<AccountFixture>("AccountManager/add_account", { 0 }, true, [](AccountFixture& f, BenchState& state) {
+        for (auto _ : state) {
+            do_not_optimize(f.accountManager.add_account(1, 100.0f));
+        }
+    });
+    registry.add<AccountFixture>("AccountManager/deposit", { 1000, 1000000 }, true, [](AccountFixture& f, BenchState& state) {
+        mt19937 rng(static_cast<unsigned>(state.thread_index));
+        for (auto _ : state) {
+            do_not_optimize(f.accountManager.deposit(f.account_ids[rng() % f.account_ids.size()], 1.0f));
+        }
+    });
+    registry.add<AccountFixture>("AccountManager/check_balance", { 1000, 1000000 }, true, [](AccountFixture& f, BenchState& state) {
+        mt19937 rng(static_cast<unsigned>(state.thread_index));
+        for (auto _ : state) {
+            do_not_optimize(f.accountManager.check_balance(f.account_ids[rng() % f.account_ids.size()]));
+        }
+    });
+    // Balance inquiries with one deposit in `arg` operations
+    registry.add<AccountFixture>("AccountManager/read_mostly_1_in", { 20, 1000 }, true, [](AccountFixture& f, BenchState& state) {
+        mt19937 rng(static_cast<unsigned>(state.thread_index));
+        int64_t i = 0;
+        for (auto _ : state) {
+            int account_id = f.account_ids[rng() % f.account_ids.size()];
+            if (++i % state.arg == 0) {
+                do_not_optimize(f.accountManager.deposit(account_id, 1.0f));
+            }
+            else {
+                do_not_optimize(f.accountManager.check_balance(account_id));
+            }
+        }
+    });
+    // Full-book report at one commit, taken without blocking writers
+    registry.add<AccountFixture>("AccountManager/snapshot", { 1000, 1000000 }, false, [](AccountFixture& f, BenchState& state) {
+        for (auto _ : state) {
+            do_not_optimize(f.accountManager.snapshot().total_balance);
+        }
+    });
+    // Customer total through the customer index; the fixture spreads the
+    // accounts over 1000 customers
+    registry.add<AccountFixture>("AccountManager/customer_balance", { 1000, 1000000 }, true, [](AccountFixture& f, BenchState& state) {
+        mt19937 rng(static_cast<unsigned>(state.thread_index));
+        for (auto _ : state) {
+            do_not_optimize(f.accountManager.customer_balance(static_cast<int>(rng() % 1000)));
+        }
+    });
+    registry.add<AccountFixture>("AccountManager/transfer", { 1000 }, true, [](AccountFixture& f, BenchState& state) {
+        mt19937 rng(static_cast<unsigned>(state.thread_index));
+        for (auto _ : state) {
+            do_not_optimize(f.accountManager.transfer(f.account_ids[rng() % f.account_ids.size()], f.account_ids[rng() % f.account_ids.size()], 1.0f));
+        }
+    });
+    registry.add<AccountFixture>("AccountManager/apply_batch_of_64", { 1000 }, true, [](AccountFixture& f, BenchState& state) {
+        mt19937 rng(static_cast<unsigned>(state.thread_index));
+        vector<AccountManager::Operation> ops(64);
+        for (auto _ : state) {
+            for (auto& op : ops) {
+                op = AccountManager::Operation{};
+                op.type = AccountManager::Operation::Deposit;
+                op.account_id = f.account_ids[rng() % f.account_ids.size()];
+                op.amount = 1.0f;
+            }
+            f.accountManager.apply_batch(ops);
+        }
+    });
+    registry.add<HotAccountFixture>("AccountManager/deposit_hot", { 0, 1 }, true, [](HotAccountFixture& f, BenchState& state) {
+        for (auto _ : state) {
+            do_not_optimize(f.accountManager.deposit(f.account_id, 1.0f));
+        }
+    });
+    registry.add<SyscallFixture>("SystemCallInterface/deposit_idempotent", { 0, 1, 2 }, true, [](SyscallFixture& f, BenchState& state) {
+        mt19937 rng(static_cast<unsigned>(state.thread_index));
+        uint64_t next_key = (static_cast<uint64_t>(state.thread_index) + 1) << 40;
+        for (auto _ : state) {
+            if (state.arg == 2) {
+                uint64_t key = rng() % SyscallFixture::RETRIED_KEYS + 1;
+                do_not_optimize(f.sysCallInterface.deposit(f.retried_account(key), 1.0f, key));
+                continue;
+            }
+            uint64_t key = state.arg == 1 ? next_key++ : 0;
+            do_not_optimize(f.sysCallInterface.deposit(f.account_ids[rng() % f.account_ids.size()], 1.0f, key));
+        }
+    });
+    registry.add<RateLimitFixture>("SystemCallInterface/deposit_rate_limited", { 0, 1 }, true, [](RateLimitFixture& f, BenchState& state) {
+        mt19937 rng(static_cast<unsigned>(state.thread_index));
+        for (auto _ : state) {
+            do_not_optimize(f.sysCallInterface.deposit(f.account_ids[rng() % f.account_ids.size()], 1.0f));
+        }
+    });
+    // Payment plus fee across random accounts; fewer accounts, more conflicts
+    registry.add<AccountFixture>("AccountManager/post_3_legs", { 8, 1000 }, true, [](AccountFixture& f, BenchState& state) {
+        mt19937 rng(static_cast<unsigned>(state.thread_index));
+        vector<AccountManager::Leg> legs(3);
+        for (auto _ : state) {
+            legs[0] = { f.account_ids[rng() % f.account_ids.size()], -1.1f };
+            legs[1] = { f.account_ids[rng() % f.account_ids.size()], 1.0f };
+            legs[2] = { f.account_ids[rng() % f.account_ids.size()], 0.1f };
+            do_not_optimize(f.accountManager.post(legs));
+        }
+    });
+
+    // ProcessManager / Scheduler: process table churn and ready-queue dispatch
+    registry.add<ProcessFixture>("ProcessManager/create_terminate", { 0 }, true, [](ProcessFixture& f, BenchState& state) {
+        for (auto _ : state) {
+            int transaction_id = f.processManager.create_transaction_process(1, 1);
+            f.processManager.update_process_state(transaction_id, "Running");
+            f.processManager.terminate_transaction_process(transaction_id);
+        }
+    });
+    registry.add<ProcessFixture>("Scheduler/add_to_ready_queue", { 0 }, true, [](ProcessFixture& f, BenchState& state) {
+        for (auto _ : state) {
+            f.scheduler.add_to_ready_queue(1);
+        }
+    });
+
+    // MemoryManager: steady-state page replacement with `arg` resident pages
+    registry.add<MemoryFixture>("MemoryManager/store_data_in_page", { 5, 4096 }, true, [](MemoryFixture& f, BenchState& state) {
+        int account_id = static_cast<int>(state.thread_index);
+        for (auto _ : state) {
+            f.memoryManager.store_data_in_page(account_id++, 1.0f);
+        }
+    });
+
+    // Locks: cost of deadlock monitoring on a short critical section
+    registry.add<LockFixture>("Lock/std_mutex", { 0 }, true, [](LockFixture& f, BenchState& state) {
+        for (auto _ : state) {
+            lock_guard<mutex> lock(f.plain);
+            do_not_optimize(++f.counter);
+        }
+    });
+    registry.add<LockFixture>("Lock/monitored_mutex", { 0, 1 }, true, [](LockFixture& f, BenchState& state) {
+        for (auto _ : state) {
+            lock_guard<MonitoredMutex> lock(f.monitored);
+            do_not_optimize(++f.counter);
+        }
+    });
+
+    // IPCManager: legacy queue round trip and pub/sub fan-out to `arg` subscribers
+    registry.add<IPCFixture>("IPCManager/send_receive", { 0 }, true, [](IPCFixture& f, BenchState& state) {
+        for (auto _ : state) {
+            f.ipcManager.send_message("Transaction completed");
+            do_not_optimize(f.ipcManager.receive_message(false));
+        }
+    });
+    registry.add<IPCFixture>("IPCManager/publish_fanout", { 1, 16, 256 }, false, [](IPCFixture& f, BenchState& state) {
+        for (auto _ : state) {
+            f.ipcManager.publish(IPCManager::event_topic("deposit"), "Deposit: Account ID=1, Amount=10.000000");
+            for (int subscriber_id : f.subscriber_ids) {
+                do_not_optimize(f.ipcManager.receive(subscriber_id, false));
+            }
+        }
+    });
+}
+
+// Run the microbenchmarks. Log files are written to a scratch directory.
+// Usage: banking_bench [--filter SUBSTRING] [--threads 1,2,4] [--min-time SECONDS]
+int main(int argc, char* argv[]) {
+    string filter;
+    vector<size_t> thread_counts = { 1, 2, 4 };
+    double min_time_s = 0.2;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string option = argv[i];
+        string value = argv[i + 1];
+        if (option == "--filter") {
+            filter = value;
+        }
+        else if (option == "--threads") {
+            thread_counts.clear();
+            stringstream counts(value);
+            string count;
+            while (getline(counts, count, ',')) {
+                thread_counts.push_back(max<size_t>(1, stoul(count)));
+            }
+        }
+        else if (option == "--min-time") {
+            min_time_s = stod(value);
+        }
+        else {
+            cerr << "Unknown option: " << option << endl;
+            return 1;
+        }
+    }
+
+    char scratch[] = "/tmp/banking-bench-XXXXXX";
+    if (!mkdtemp(scratch) || chdir(scratch) != 0) {
+        cerr << "Failed to create a scratch directory for benchmark logs" << endl;
+        return 1;
+    }
+    BenchmarkRegistry registry;
+    register_benchmarks(registry);
+    registry.run(filter, thread_counts, min_time_s);
+
+    // Logs, rotated segments and their indexes
+    if (chdir("/") == 0) {
+        filesystem::remove_all(scratch);
+    }
+    return 0;
+}
@@ -0,0 +1,64 @@
+#include "microbench.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+
+void BenchmarkRegistry::run(const string& filter, const vector<size_t>& thread_counts, double min_time_s) {
+    cout << left << setw(48) << "Benchmark" << right << setw(14) << "ns/op" << setw(16) << "ops/s" << setw(14) << "iterations" << endl;
+    for (const auto& benchmark : benchmarks) {
+        if (!filter.empty() && benchmark.name.find(filter) == string::npos) {
+            continue;
+        }
+        vector<size_t> threads_to_run = benchmark.multi_threaded ? thread_counts : vector<size_t>{ 1 };
+        for (int64_t arg : benchmark.args) {
+            for (size_t threads : threads_to_run) {
+                auto body = benchmark.prepare(arg);
+                size_t iterations = 1;
+                double seconds = 0;
+                // Grow the iteration count until a run lasts long enough to trust
+                while (true) {
+                    seconds = run_once(body, iterations, arg, threads);
+                    if (seconds >= min_time_s || iterations >= (1ull << 30)) {
+                        break;
+                    }
+                    double scale = seconds > 0 ? min_time_s * 1.4 / seconds : 10.0;
+                    iterations = static_cast<size_t>(iterations * min(max(scale, 2.0), 100.0));
+                }
+                double total_ops = static_cast<double>(iterations) * threads;
+                string label = benchmark.name + "/" + to_string(arg) + (benchmark.multi_threaded ? "/threads:" + to_string(threads) : "");
+                cout << left << setw(48) << label << right << fixed << setprecision(1)
+                     << setw(14) << seconds * 1e9 / iterations
+                     << setw(16) << setprecision(0) << total_ops / seconds
+                     << setw(14) << iterations << endl;
+                cout.unsetf(ios::floatfield);
+            }
+        }
+    }
+}
+
+double BenchmarkRegistry::run_once(const function<void(BenchState&)>& body, size_t iterations, int64_t arg, size_t threads) {
+    vector<double> times(threads);
+    atomic<size_t> ready{ 0 };
+    vector<thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            BenchState state(iterations, arg, t, threads);
+            // Line the threads up so they contend for the whole run
+            ready++;
+            while (ready.load() < threads) {
+                this_thread::yield();
+            }
+            body(state);
+            times[t] = chrono::duration<double>(state.time()).count();
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return *max_element(times.begin(), times.end());
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A small Google Benchmark-style harness. A benchmark body loops with
+// `for (auto _ : state)` over a fixture shared by all of its threads; the
+// harness runs it for every (argument, thread count) pair, growing the
+// iteration count until the run lasts at least the minimum time, and
+// reports per-operation latency and aggregate throughput.
+class BenchState {
+private:
+    size_t iterations;
+    std::chrono::steady_clock::time_point started;
+    std::chrono::steady_clock::duration elapsed{};
+
+public:
+    const int64_t arg;         // Data size parameter of this run
+    const size_t thread_index; // 0 .. threads-1
+    const size_t threads;
+
+    struct Iterator {
+        BenchState* state;
+        size_t remaining;
+
+        bool operator!=(const Iterator&) {
+            if (remaining != 0) {
+                return true;
+            }
+            state->elapsed = std::chrono::steady_clock::now() - state->started;
+            return false;
+        }
+        void operator++() { --remaining; }
+        // Non-trivial so `for (auto _ : state)` does not warn about an unused variable
+        struct Value {
+            Value() {}
+            ~Value() {}
+        };
+        Value operator*() const { return {}; }
+    };
+
+    BenchState(size_t iterations, int64_t arg, size_t thread_index, size_t threads)
+        : iterations(iterations), arg(arg), thread_index(thread_index), threads(threads) {}
+
+    Iterator begin() {
+        started = std::chrono::steady_clock::now();
+        return { this, iterations };
+    }
+
+    Iterator end() { return { this, 0 }; }
+
+    std::chrono::steady_clock::duration time() const { return elapsed; }
+};
+
+// Keep the optimizer from discarding a benchmarked result
+template <typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+class BenchmarkRegistry {
+private:
+    struct Benchmark {
+        std::string name;
+        std::vector<int64_t> args;
+        bool multi_threaded;
+        // Builds the shared fixture for one argument and returns the per-thread body
+        std::function<std::function<void(BenchState&)>(int64_t)> prepare;
+    };
+
+    std::vector<Benchmark> benchmarks;
+
+public:
+    // Register `body(fixture, state)`; a fresh Fixture(arg) is shared by the
+    // threads of each run. Single-threaded benchmarks ignore the thread list.
+    template <typename Fixture>
+    void add(const std::string& name, std::vector<int64_t> args, bool multi_threaded, std::function<void(Fixture&, BenchState&)> body) {
+        benchmarks.push_back({ name, std::move(args), multi_threaded, [body](int64_t arg) {
+            auto fixture = std::make_shared<Fixture>(arg);
+            return std::function<void(BenchState&)>([fixture, body](BenchState& state) { body(*fixture, state); });
+        } });
+    }
+
+    void run(const std::string& filter, const std::vector<size_t>& thread_counts, double min_time_s);
+
+private:
+    // Run `iterations` per thread concurrently; returns the slowest thread's loop time
+    static double run_once(const std::function<void(BenchState&)>& body, size_t iterations, int64_t arg, size_t threads);
+};
@@ -1,5 +1,4 @@
 /*
-/*
 Project: A Simple Banking System Simulation in C++
 
 Objective:
@@ -126,390 +125,24 @@ Example User Scenarios:
 
 Write the complete C++ implementation for the above system. Ensure all modules, synchronization, logging, error handling, and visualization are implemented as described. Follow clean and modular coding practices.
 */
+#include <chrono>
 #include <iostream>
-#include <map>
-#include <mutex>
 #include <thread>
-#include <fstream>
-#include <queue>
-#include <list>
-#include <condition_variable>
-#include <chrono>
-#include <vector>
-#include <atomic>
-#include <iomanip>
-#include <ctime>
-#include <string>
-
-using namespace std;
-
-// Logger class for transaction and error logging
-class Logger {
-private:
-    ofstream transaction_log;
-    ofstream error_log;
-    mutex log_mtx;
-
-    string get_current_time() {
-        auto now = chrono::system_clock::now();
-        time_t now_time = chrono::system_clock::to_time_t(now);
-        char buffer[26];
-        ctime_s(buffer, sizeof(buffer), &now_time);
-        buffer[24] = '\0'; // Remove the newline character
-        return string(buffer);
-    }
-
-public:
-    Logger() {
-        transaction_log.open("transactions.log", ios::app);
-        error_log.open("errors.log", ios::app);
-    }
-
-    ~Logger() {
-        transaction_log.close();
-        error_log.close();
-    }
-
-    void log_transaction(const string& message) {
-        lock_guard<mutex> lock(log_mtx);
-        transaction_log << "[" << get_current_time() << "] " << message << endl;
-    }
-
-    void log_error(const string& message) {
-        lock_guard<mutex> lock(log_mtx);
-        error_log << "[" << get_current_time() << "] " << message << endl;
-    }
-};
-
-// AccountManager class for account operations
-class AccountManager {
-private:
-    struct Account {
-        int account_id;
-        int customer_id;
-        float balance;
-    };
-
-    map<int, Account> accounts;
-    mutex mtx;
-    int next_account_id = 1;
-    Logger& logger;
-
-public:
-    AccountManager(Logger& logger) : logger(logger) {}
-
-    int add_account(int customer_id, float initial_balance) {
-        lock_guard<mutex> lock(mtx);
-        int account_id = next_account_id++;
-        accounts[account_id] = { account_id, customer_id, initial_balance };
-        logger.log_transaction("Account created: ID=" + to_string(account_id) + ", Initial Balance=" + to_string(initial_balance));
-        return account_id;
-    }
-
-    Account get_account(int account_id) {
-        lock_guard<mutex> lock(mtx);
-        if (accounts.find(account_id) != accounts.end()) {
-            return accounts[account_id];
-        }
-        logger.log_error("Get account failed: Invalid Account ID=" + to_string(account_id));
-        return { -1, -1, -1.0f }; // Indicate invalid account
-    }
-
-    bool update_balance(int account_id, float new_balance) {
-        lock_guard<mutex> lock(mtx);
-        if (accounts.find(account_id) != accounts.end()) {
-            accounts[account_id].balance = new_balance;
-            logger.log_transaction("Balance updated: Account ID=" + to_string(account_id) + ", New Balance=" + to_string(new_balance));
-            return true;
-        }
-        logger.log_error("Update balance failed: Invalid Account ID=" + to_string(account_id));
-        return false;
-    }
-
-    bool delete_account(int account_id) {
-        lock_guard<mutex> lock(mtx);
-        if (accounts.erase(account_id)) {
-            logger.log_transaction("Account deleted: ID=" + to_string(account_id));
-            return true;
-        }
-        logger.log_error("Delete account failed: Invalid Account ID=" + to_string(account_id));
-        return false;
-    }
-
-    bool deposit(int account_id, float amount) {
-        lock_guard<mutex> lock(mtx);
-        if (accounts.find(account_id) != accounts.end()) {
-            accounts[account_id].balance += amount;
-            logger.log_transaction("Deposit: Account ID=" + to_string(account_id) + ", Amount=" + to_string(amount));
-            return true;
-        }
-        logger.log_error("Deposit failed: Invalid Account ID=" + to_string(account_id));
-        return false;
-    }
-
-    bool withdraw(int account_id, float amount) {
-        lock_guard<mutex> lock(mtx);
-        if (accounts.find(account_id) != accounts.end() && accounts[account_id].balance >= amount) {
-            accounts[account_id].balance -= amount;
-            logger.log_transaction("Withdrawal: Account ID=" + to_string(account_id) + ", Amount=" + to_string(amount));
-            return true;
-        }
-        logger.log_error("Withdrawal failed: Insufficient funds or Invalid Account ID=" + to_string(account_id));
-        return false;
-    }
-
-    float check_balance(int account_id) {
-        lock_guard<mutex> lock(mtx);
-        if (accounts.find(account_id) != accounts.end()) {
-            return accounts[account_id].balance;
-        }
-        logger.log_error("Check balance failed: Invalid Account ID=" + to_string(account_id));
-        return -1.0f; // Indicate invalid account
-    }
-};
-
-// ProcessManager class for process creation and management
-class ProcessManager {
-private:
-    struct Process {
-        int transaction_id;
-        string state;
-        int account_id;
-        int customer_id;
-
-        // Constructor to initialize member variables
-        Process(int t_id, const string& st, int a_id, int c_id)
-            : transaction_id(t_id), state(st), account_id(a_id), customer_id(c_id) {
-        }
-    };
-
-    map<int, Process> process_table;
-    mutex mtx;
-    int next_transaction_id = 1;
-
-public:
-    int create_transaction_process(int customer_id, int account_id) {
-        lock_guard<mutex> lock(mtx);
-        int transaction_id = next_transaction_id++;
-        process_table[transaction_id] = Process(transaction_id, "Ready", account_id, customer_id);
-        return transaction_id;
-    }
-
-    void terminate_transaction_process(int transaction_id) {
-        lock_guard<mutex> lock(mtx);
-        if (process_table.find(transaction_id) != process_table.end()) {
-            process_table[transaction_id].state = "Terminated";
-            process_table.erase(transaction_id);
-        }
-    }
-
-    void update_process_state(int transaction_id, const string& state) {
-        lock_guard<mutex> lock(mtx);
-        if (process_table.find(transaction_id) != process_table.end()) {
-            process_table[transaction_id].state = state;
-        }
-    }
-
-    void remove_process(int transaction_id) {
-        lock_guard<mutex> lock(mtx);
-        process_table.erase(transaction_id);
-    }
-
-    map<int, Process> get_process_table() {
-        lock_guard<mutex> lock(mtx);
-        return process_table;
-    }
-};
-
-// Scheduler class for CPU scheduling
-class Scheduler {
-private:
-    queue<int> ready_queue;
-    mutex mtx;
-    condition_variable cv;
-    atomic<bool> running;
-    ProcessManager& process_manager;
-    vector<pair<int, string>> gantt_chart;
-    int time_slice;
-
-public:
-    Scheduler(ProcessManager& pm, int ts) : process_manager(pm), running(true), time_slice(ts) {}
-
-    void add_to_ready_queue(int transaction_id) {
-        lock_guard<mutex> lock(mtx);
-        ready_queue.push(transaction_id);
-        cv.notify_one();
-    }
-
-    void stop() {
-        running = false;
-        cv.notify_all();
-    }
-
-    void run() {
-        while (running) {
-            unique_lock<mutex> lock(mtx);
-            cv.wait(lock, [this] { return !ready_queue.empty() || !running; });
-
-            if (!running) break;
-
-            int transaction_id = ready_queue.front();
-            ready_queue.pop();
-            lock.unlock();
-
-            process_manager.update_process_state(transaction_id, "Running");
-            this_thread::sleep_for(chrono::milliseconds(time_slice)); // Simulate process execution
-            process_manager.update_process_state(transaction_id, "Terminated");
-
-            gantt_chart.push_back({ transaction_id, "Running" });
-        }
-    }
-
-    void display_gantt_chart() {
-        cout << "Gantt Chart:" << endl;
-        for (const auto& entry : gantt_chart) {
-            cout << "Transaction ID: " << entry.first << " - State: " << entry.second << endl;
-        }
-    }
-};
-
-// MemoryManager class for paging and memory management
-class MemoryManager {
-private:
-    struct Page {
-        int account_id;
-        float balance;
-    };
-
-    list<Page> memory;
-    size_t max_pages;
-    mutex mtx;
-
-public:
-    MemoryManager(size_t max_pages) : max_pages(max_pages) {}
-
-    void store_data_in_page(int account_id, float balance) {
-        lock_guard<mutex> lock(mtx);
-        if (memory.size() >= max_pages) {
-            replace_page(account_id, balance);
-        }
-        else {
-            memory.push_back({ account_id, balance });
-        }
-    }
-
-    void replace_page(int account_id, float balance) {
-        lock_guard<mutex> lock(mtx);
-        memory.pop_front(); // Remove the least recently used page
-        memory.push_back({ account_id, balance });
-    }
-
-    void display_memory_map() {
-        lock_guard<mutex> lock(mtx);
-        cout << "Memory Map:" << endl;
-        for (const auto& page : memory) {
-            cout << "Account ID: " << page.account_id << ", Balance: " << page.balance << endl;
-        }
-    }
-};
-
-// IPCManager class for message queue handling
-class IPCManager {
-private:
-    queue<string> message_queue;
-    mutex mtx;
-    condition_variable cv;
-
-public:
-    void send_message(const string& message) {
-        lock_guard<mutex> lock(mtx);
-        message_queue.push(message);
-        cv.notify_one();
-    }
-
-    string receive_message(bool blocking = true) {
-        unique_lock<mutex> lock(mtx);
-        if (blocking) {
-            cv.wait(lock, [this] { return !message_queue.empty(); });
-        }
-        else {
-            if (message_queue.empty()) {
-                return "";
-            }
-        }
-        string message = message_queue.front();
-        message_queue.pop();
-        return message;
-    }
-};
-
-// Error Handling Module
-class ErrorHandler {
-private:
-    Logger& logger;
-
-public:
-    ErrorHandler(Logger& logger) : logger(logger) {}
-
-    void handle_error(const string& error_message) {
-        logger.log_error(error_message);
-    }
-
-    bool validate_account_id(int account_id, AccountManager& accountManager) {
-        if (accountManager.get_account(account_id).account_id == -1) {
-            handle_error("Invalid Account ID: " + to_string(account_id));
-            return false;
-        }
-        return true;
-    }
-
-    bool validate_amount(float amount) {
-        if (amount <= 0) {
-            handle_error("Invalid amount: " + to_string(amount));
-            return false;
-        }
-        return true;
-    }
-};
-
-// System Call Interface Module
-class SystemCallInterface {
-private:
-    AccountManager& accountManager;
-    ErrorHandler& errorHandler;
-
-public:
-    SystemCallInterface(AccountManager& am, ErrorHandler& eh) : accountManager(am), errorHandler(eh) {}
-
-    int create_account(int customer_id, float initial_balance) {
-        if (initial_balance < 0) {
-            errorHandler.handle_error("Create account failed: Initial balance cannot be negative.");
-            return -1;
-        }
-        return accountManager.add_account(customer_id, initial_balance);
-    }
-
-    bool deposit(int account_id, float amount) {
-        if (!errorHandler.validate_account_id(account_id, accountManager) || !errorHandler.validate_amount(amount)) {
-            return false;
-        }
-        return accountManager.deposit(account_id, amount);
-    }
 
-    bool withdraw(int account_id, float amount) {
-        if (!errorHandler.validate_account_id(account_id, accountManager) || !errorHandler.validate_amount(amount)) {
-            return false;
-        }
-        return accountManager.withdraw(account_id, amount);
-    }
+#include "account_manager.h"
+#include "error_handler.h"
+#include "executor.h"
+#include "ipc_manager.h"
+#include "lock_monitor.h"
+#include "logger.h"
+#include "memory_manager.h"
+#include "process_manager.h"
+#include "scheduler.h"
+#include "system_call_interface.h"
+#include "task.h"
+#include "transaction_pipeline.h"
 
-    float check_balance(int account_id) {
-        if (!errorHandler.validate_account_id(account_id, accountManager)) {
-            return -1.0f;
-        }
-        return accountManager.check_balance(account_id);
-    }
-};
+using namespace std;
 
 // Multithreading & Synchronization Module
 void run_transaction(SystemCallInterface& sysCallInterface, int account_id, float amount, bool is_deposit) {
@@ -521,15 +154,38 @@ void run_transaction(SystemCallInterface& sysCallInterface, int account_id, floa
     }
 }
 
+// Coroutine transaction: move funds, wait for the withdrawal notification,
+// then make sure the records are on disk
+Task<void> transfer_task(TransactionPipeline& pipeline, int subscriber_id, int from_account, int to_account, float amount) {
+    if (co_await pipeline.withdraw(from_account, amount)) {
+        co_await pipeline.deposit(to_account, amount);
+        auto event = co_await pipeline.receive(subscriber_id);
+        if (event) {
+            cout << "Coroutine transfer confirmed: " << event->payload << endl;
+        }
+    }
+    co_await pipeline.flush_log();
+}
+
 int main() {
     Logger logger;
+    LockMonitor::set_logger(&logger); // Deadlocks between the managers' locks go to errors.log
     AccountManager accountManager(logger);
     ErrorHandler errorHandler(logger);
     ProcessManager processManager;
     Scheduler scheduler(processManager, 100); // 100 milliseconds time slice
     MemoryManager memoryManager(5);
     IPCManager ipcManager;
-    SystemCallInterface sysCallInterface(accountManager, errorHandler);
+    SystemCallInterface sysCallInterface(accountManager, errorHandler, &ipcManager);
+
+    // Consumers only receive the events they subscribe to
+    int audit_subscriber = ipcManager.subscribe(IPCManager::ALL_TOPICS);
+    int fraud_subscriber = ipcManager.subscribe(IPCManager::event_topic("withdraw"));
+    int notification_subscriber = ipcManager.subscribe(IPCManager::customer_topic(1));
+    ipcManager.on_message(notification_subscriber, [](IPCManager::MessagePtr event) {
+        cout << "Notify customer 1: " << event->payload << endl;
+    });
+    thread ipc_event_thread(&IPCManager::run_event_loop, &ipcManager);
 
     thread scheduler_thread(&Scheduler::run, &scheduler);
 
@@ -565,6 +221,31 @@ int main() {
     ipcManager.send_message("Transaction completed for Account ID 2");
     cout << "IPC Message 1: " << ipcManager.receive_message() << endl;
     cout << "IPC Message 2: " << ipcManager.receive_message() << endl;
+    string third_message = ipcManager.receive_for(chrono::milliseconds(10));
+    cout << "IPC Message 3: " << (third_message.empty() ? "(timed out)" : third_message) << endl;
+
+    while (auto event = ipcManager.receive(fraud_subscriber, false)) {
+        cout << "Fraud check: " << event->payload << endl;
+    }
+    size_t audited = 0;
+    while (ipcManager.receive(audit_subscriber, false)) {
+        audited++;
+    }
+    cout << "Audit events received: " << audited << endl;
+
+    ipcManager.stop_event_loop();
+    ipc_event_thread.join();
+
+    // Coroutine pipeline: many transactions multiplexed on one executor thread
+    {
+        Executor executor(1);
+        Executor io_executor(1);
+        TransactionPipeline pipeline(sysCallInterface, ipcManager, logger, executor, io_executor);
+        int transfer_subscriber = ipcManager.subscribe(IPCManager::account_topic(account_id2));
+        executor.spawn(transfer_task(pipeline, transfer_subscriber, account_id2, account_id1, 50.0f));
+        executor.wait_idle();
+        ipcManager.unsubscribe(transfer_subscriber);
+    }
 
     processManager.terminate_transaction_process(transaction_id1);
     processManager.terminate_transaction_process(transaction_id2);
@@ -574,7 +255,6 @@ int main() {
 
     scheduler.display_gantt_chart();
 
+    LockMonitor::set_logger(nullptr);
     return 0;
 }
-
-
@@ -0,0 +1,761 @@
+#include "account_manager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+atomic<size_t> next_stripe{ 0 };
+
+// Hot deposit stripe of the calling thread
+size_t local_stripe() {
+    thread_local size_t stripe = next_stripe.fetch_add(1, memory_order_relaxed);
+    return stripe;
+}
+
+}
+
+AccountManager::AccountManager(Logger& logger, const TransactionPolicy& transaction_policy,
+                               const HotAccountPolicy& hot_policy)
+    : chunks(new atomic<Chunk*>[MAX_CHUNKS]), logger(logger), hot_policy(hot_policy),
+      transaction_policy(transaction_policy) {
+    for (size_t i = 0; i < MAX_CHUNKS; ++i) {
+        chunks[i].store(nullptr, memory_order_relaxed);
+    }
+}
+
+AccountManager::~AccountManager() {
+    for (size_t i = 0; i < MAX_CHUNKS; ++i) {
+        Chunk* chunk = chunks[i].load(memory_order_relaxed);
+        if (chunk == nullptr) {
+            continue;
+        }
+        for (auto& slot : *chunk) {
+            AccountRecord* record = slot.load(memory_order_relaxed);
+            if (record == nullptr) {
+                continue;
+            }
+            for (Version* version = record->head.load(memory_order_relaxed); version != nullptr;) {
+                Version* older = version->older.load(memory_order_relaxed);
+                delete version;
+                version = older;
+            }
+            delete record->hot.load(memory_order_relaxed);
+            delete record;
+        }
+        delete chunk;
+    }
+    for (Version* version : spare_versions) {
+        delete version;
+    }
+}
+
+double AccountManager::HotBalance::total() const {
+    double sum = 0.0;
+    for (const Stripe& stripe : stripes) {
+        sum += stripe.total.load(memory_order_relaxed);
+    }
+    return sum;
+}
+
+double AccountManager::HotBalance::seal() {
+    double sum = 0.0;
+    for (Stripe& stripe : stripes) {
+        sum += stripe.total.exchange(numeric_limits<double>::quiet_NaN(), memory_order_acq_rel);
+    }
+    return sum;
+}
+
+void AccountManager::fold_hot() {
+    if (!any_hot.load(memory_order_acquire)) {
+        return;
+    }
+    lock_guard<MonitoredMutex> lock(mtx);
+    for (AccountRecord* record : hot_records) {
+        fold_locked(*record);
+    }
+    publish_locked();
+}
+
+AccountManager::CustomerShard& AccountManager::customer_shard(int customer_id) {
+    return customers[static_cast<uint32_t>(customer_id) % CUSTOMER_SHARDS];
+}
+
+vector<int> AccountManager::indexed_accounts(int customer_id) {
+    CustomerShard& shard = customer_shard(customer_id);
+    lock_guard<MonitoredMutex> lock(shard.mtx);
+    auto it = shard.accounts.find(customer_id);
+    return it == shard.accounts.end() ? vector<int>() : it->second;
+}
+
+AccountManager::AccountRecord* AccountManager::find_record(int account_id) const {
+    if (account_id <= 0) {
+        return nullptr;
+    }
+    size_t index = static_cast<size_t>(account_id);
+    if (index / CHUNK_ACCOUNTS >= MAX_CHUNKS) {
+        return nullptr;
+    }
+    Chunk* chunk = chunks[index / CHUNK_ACCOUNTS].load(memory_order_acquire);
+    return chunk == nullptr ? nullptr : (*chunk)[index % CHUNK_ACCOUNTS].load(memory_order_acquire);
+}
+
+AccountManager::Version* AccountManager::visible(const AccountRecord& record, uint64_t snapshot) {
+    Version* version = record.head.load(memory_order_acquire);
+    while (version != nullptr && version->commit > snapshot) {
+        version = version->older.load(memory_order_acquire);
+    }
+    return version;
+}
+
+bool AccountManager::read_latest(const AccountRecord& record, float& balance, uint64_t& sequence) {
+    for (;;) {
+        uint64_t before = record.sequence.load(memory_order_acquire);
+        if (before & 1) {
+            // A commit is updating the record; let it finish
+            this_thread::yield();
+            continue;
+        }
+        float value = record.balance.load(memory_order_relaxed);
+        bool live = record.live.load(memory_order_relaxed);
+        HotBalance* hot = record.hot.load(memory_order_acquire);
+        if (hot != nullptr && live) {
+            double total = hot->total();
+            if (isnan(total)) {
+                // delete_account() has sealed the stripes; let it publish
+                this_thread::yield();
+                continue;
+            }
+            // The stripes are at least as new as the fold that set `folded`,
+            // so deposits counted in both cancel out
+            double folded = record.folded.load(memory_order_relaxed);
+            value += static_cast<float>(total - folded);
+        }
+        atomic_thread_fence(memory_order_acquire);
+        if (record.sequence.load(memory_order_relaxed) == before) {
+            balance = value;
+            sequence = before;
+            return live;
+        }
+    }
+}
+
+bool AccountManager::read_latest(const AccountRecord& record, float& balance) {
+    uint64_t sequence;
+    return read_latest(record, balance, sequence);
+}
+
+bool AccountManager::commit_if_unchanged(const vector<AccountRecord*>& records, const vector<uint64_t>& sequences,
+                                         const vector<float>& balances) {
+    lock_guard<MonitoredMutex> lock(mtx);
+    // Sequences only move under mtx, so an unchanged sequence means the
+    // balance read is still the latest
+    for (size_t i = 0; i < records.size(); ++i) {
+        // A record promoted since the read has deposits the read counted
+        // but the commit would not fold
+        if (records[i]->sequence.load(memory_order_relaxed) != sequences[i] ||
+            records[i]->hot.load(memory_order_relaxed) != nullptr) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < records.size(); ++i) {
+        install_locked(*records[i], balances[i], true);
+    }
+    publish_locked();
+    return true;
+}
+
+bool AccountManager::run_transaction(const char* name, const vector<int>& account_ids, const TransactionBody& body,
+                                     vector<float>& balances, vector<float>& new_balances) {
+    size_t count = account_ids.size();
+    for (size_t i = 0; i < count; ++i) {
+        if (find(account_ids.begin(), account_ids.begin() + i, account_ids[i]) != account_ids.begin() + i) {
+            transactions_rejected.fetch_add(1, memory_order_relaxed);
+            logger.log<LogLevel::Error>(LogCategory::Account, name, " failed: Duplicate Account ID=", account_ids[i]);
+            return false;
+        }
+    }
+    balances.resize(count);
+    vector<AccountRecord*> records(count);
+    vector<uint64_t> sequences(count);
+
+    // Stripe deposits do not move the sequence, so transactions on hot
+    // accounts cannot be validated optimistically
+    uint32_t attempts = transaction_policy.optimistic_attempts;
+    for (int account_id : account_ids) {
+        AccountRecord* record = find_record(account_id);
+        if (record != nullptr && record->hot.load(memory_order_acquire) != nullptr) {
+            attempts = 0;
+        }
+    }
+    for (uint32_t attempt = 0; attempt < attempts; ++attempt) {
+        for (size_t i = 0; i < count; ++i) {
+            records[i] = find_record(account_ids[i]);
+            if (records[i] == nullptr || !read_latest(*records[i], balances[i], sequences[i])) {
+                transactions_rejected.fetch_add(1, memory_order_relaxed);
+                logger.log<LogLevel::Error>(LogCategory::Account, name, " failed: Invalid Account ID=", account_ids[i]);
+                return false;
+            }
+        }
+        new_balances = balances;
+        if (!body(balances, new_balances) || new_balances.size() != count) {
+            transactions_rejected.fetch_add(1, memory_order_relaxed);
+            logger.log<LogLevel::Error>(LogCategory::Account, name, " failed: Rejected, First Account ID=", account_ids.empty() ? -1 : account_ids[0]);
+            return false;
+        }
+        if (commit_if_unchanged(records, sequences, new_balances)) {
+            optimistic_commits.fetch_add(1, memory_order_relaxed);
+            transactions_committed.fetch_add(1, memory_order_relaxed);
+            return true;
+        }
+        optimistic_aborts.fetch_add(1, memory_order_relaxed);
+    }
+
+    // Conflicts keep winning: hold the writer lock from read to commit so the
+    // transaction cannot lose again
+    if (!mtx.lock_or_abort()) {
+        deadlock_aborts.fetch_add(1, memory_order_relaxed);
+        transactions_rejected.fetch_add(1, memory_order_relaxed);
+        logger.log<LogLevel::Error>(LogCategory::Account, name, " failed: Deadlock victim, First Account ID=", account_ids.empty() ? -1 : account_ids[0]);
+        return false;
+    }
+    lock_guard<MonitoredMutex> lock(mtx, adopt_lock);
+    for (size_t i = 0; i < count; ++i) {
+        records[i] = live_record_locked(account_ids[i]);
+        if (records[i] == nullptr) {
+            transactions_rejected.fetch_add(1, memory_order_relaxed);
+            logger.log<LogLevel::Error>(LogCategory::Account, name, " failed: Invalid Account ID=", account_ids[i]);
+            return false;
+        }
+        fold_locked(*records[i]);
+        balances[i] = records[i]->head.load(memory_order_relaxed)->balance;
+    }
+    new_balances = balances;
+    if (!body(balances, new_balances) || new_balances.size() != count) {
+        transactions_rejected.fetch_add(1, memory_order_relaxed);
+        logger.log<LogLevel::Error>(LogCategory::Account, name, " failed: Rejected, First Account ID=", account_ids.empty() ? -1 : account_ids[0]);
+        return false;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        install_locked(*records[i], new_balances[i], true);
+    }
+    publish_locked();
+    locked_commits.fetch_add(1, memory_order_relaxed);
+    transactions_committed.fetch_add(1, memory_order_relaxed);
+    return true;
+}
+
+AccountManager::AccountRecord* AccountManager::live_record_locked(int account_id) {
+    AccountRecord* record = find_record(account_id);
+    if (record == nullptr) {
+        return nullptr;
+    }
+    // Writers are serialized, so the head is always the latest commit
+    Version* head = record->head.load(memory_order_relaxed);
+    return head != nullptr && head->live ? record : nullptr;
+}
+
+void AccountManager::note_deposit_locked(AccountRecord& record) {
+    if (!hot_policy.auto_promote || hot_policy.window_deposits == 0) {
+        return;
+    }
+    uint64_t window = deposits_locked++ / hot_policy.window_deposits;
+    if (record.deposit_window != window) {
+        record.deposit_window = window;
+        record.window_deposits = 0;
+    }
+    if (++record.window_deposits == hot_policy.promote_deposits) {
+        promote_locked(record);
+    }
+}
+
+void AccountManager::promote_locked(AccountRecord& record) {
+    if (record.hot.load(memory_order_relaxed) != nullptr) {
+        return;
+    }
+    record.hot.store(new HotBalance, memory_order_release);
+    hot_records.push_back(&record);
+    any_hot.store(true, memory_order_release);
+    logger.log<LogLevel::Audit>(LogCategory::Account, "Account promoted to hot: ID=", record.account_id);
+}
+
+void AccountManager::fold_locked(AccountRecord& record) {
+    HotBalance* hot = record.hot.load(memory_order_relaxed);
+    Version* head = record.head.load(memory_order_relaxed);
+    // A deleted account's stripes are sealed
+    if (hot == nullptr || !head->live) {
+        return;
+    }
+    double total = hot->total();
+    if (total == head->folded) {
+        return;
+    }
+    install_locked(record, head->balance + static_cast<float>(total - head->folded), head->live);
+    record.head.load(memory_order_relaxed)->folded = total;
+}
+
+bool AccountManager::reserve_locked(AccountRecord& record, float amount) {
+    if (record.head.load(memory_order_relaxed)->balance >= amount) {
+        return true;
+    }
+    fold_locked(record);
+    return record.head.load(memory_order_relaxed)->balance >= amount;
+}
+
+void AccountManager::install_locked(AccountRecord& record, float balance, bool live) {
+    if (!record.pending) {
+        record.pending = true;
+        pending.push_back(&record);
+    }
+    uint64_t commit = snapshots.next_commit();
+    Version* head = record.head.load(memory_order_relaxed);
+    if (head != nullptr && head->commit == commit) {
+        // Already changed in this commit, which no reader can see yet
+        head->balance = balance;
+        head->live = live;
+        return;
+    }
+
+    Version* version;
+    if (!spare_versions.empty()) {
+        version = spare_versions.back();
+        spare_versions.pop_back();
+    }
+    else {
+        version = new Version;
+    }
+    version->commit = commit;
+    version->balance = balance;
+    version->live = live;
+    version->folded = head != nullptr ? head->folded : 0.0;
+    version->older.store(head, memory_order_relaxed);
+    record.head.store(version, memory_order_release);
+
+    if (head != nullptr && !record.collectable) {
+        record.collectable = true;
+        versioned.push_back(&record);
+    }
+    ++versions_since_collect;
+}
+
+void AccountManager::publish_locked() {
+    snapshots.publish(snapshots.next_commit());
+    for (AccountRecord* record : pending) {
+        Version* head = record->head.load(memory_order_relaxed);
+        uint64_t sequence = record->sequence.load(memory_order_relaxed);
+        record->sequence.store(sequence + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        record->balance.store(head->balance, memory_order_relaxed);
+        record->live.store(head->live, memory_order_relaxed);
+        record->folded.store(head->folded, memory_order_relaxed);
+        record->sequence.store(sequence + 2, memory_order_release);
+        record->pending = false;
+    }
+    pending.clear();
+    if (versions_since_collect >= COLLECT_INTERVAL) {
+        collect_locked();
+    }
+}
+
+size_t AccountManager::collect_locked() {
+    versions_since_collect = 0;
+    uint64_t horizon = snapshots.collect_horizon();
+    size_t freed = 0;
+    size_t kept = 0;
+    for (AccountRecord* record : versioned) {
+        // Every reader stops at or before the newest version at the horizon,
+        // so anything older is unreachable
+        Version* oldest_visible = visible(*record, horizon);
+        if (oldest_visible != nullptr) {
+            Version* garbage = oldest_visible->older.load(memory_order_relaxed);
+            oldest_visible->older.store(nullptr, memory_order_release);
+            while (garbage != nullptr) {
+                Version* older = garbage->older.load(memory_order_relaxed);
+                if (spare_versions.size() < COLLECT_INTERVAL) {
+                    spare_versions.push_back(garbage);
+                }
+                else {
+                    delete garbage;
+                }
+                garbage = older;
+                ++freed;
+            }
+        }
+        if (record->head.load(memory_order_relaxed)->older.load(memory_order_relaxed) != nullptr) {
+            versioned[kept++] = record;
+        }
+        else {
+            record->collectable = false;
+            if (!record->head.load(memory_order_relaxed)->live) {
+                unindex_customer_locked(*record);
+            }
+        }
+    }
+    versioned.resize(kept);
+    return freed;
+}
+
+void AccountManager::unindex_customer_locked(const AccountRecord& record) {
+    CustomerShard& shard = customer_shard(record.customer_id);
+    lock_guard<MonitoredMutex> lock(shard.mtx);
+    auto it = shard.accounts.find(record.customer_id);
+    if (it == shard.accounts.end()) {
+        return;
+    }
+    vector<int>& account_ids = it->second;
+    account_ids.erase(remove(account_ids.begin(), account_ids.end(), record.account_id), account_ids.end());
+    if (account_ids.empty()) {
+        shard.accounts.erase(it);
+    }
+}
+
+int AccountManager::add_account_locked(int customer_id, float initial_balance) {
+    int account_id = next_account_id.load(memory_order_relaxed);
+    size_t index = static_cast<size_t>(account_id);
+    if (index / CHUNK_ACCOUNTS >= MAX_CHUNKS) {
+        logger.log<LogLevel::Error>(LogCategory::Account, "Account creation failed: Account table is full");
+        return -1;
+    }
+    atomic<Chunk*>& chunk_slot = chunks[index / CHUNK_ACCOUNTS];
+    Chunk* chunk = chunk_slot.load(memory_order_relaxed);
+    if (chunk == nullptr) {
+        chunk = new Chunk{};
+        chunk_slot.store(chunk, memory_order_release);
+    }
+
+    AccountRecord* record = new AccountRecord{ account_id, customer_id };
+    install_locked(*record, initial_balance, true);
+    (*chunk)[index % CHUNK_ACCOUNTS].store(record, memory_order_release);
+    next_account_id.store(account_id + 1, memory_order_release);
+    {
+        // Indexed before the commit is published, so every snapshot that
+        // sees the account finds it
+        CustomerShard& shard = customer_shard(customer_id);
+        lock_guard<MonitoredMutex> lock(shard.mtx);
+        shard.accounts[customer_id].push_back(account_id);
+    }
+    logger.log<LogLevel::Audit>(LogCategory::Account, "Account created: ID=", account_id, ", Initial Balance=", initial_balance);
+    return account_id;
+}
+
+bool AccountManager::deposit_locked(int account_id, float amount) {
+    AccountRecord* record = live_record_locked(account_id);
+    if (record != nullptr) {
+        install_locked(*record, record->head.load(memory_order_relaxed)->balance + amount, true);
+        note_deposit_locked(*record);
+        logger.log<LogLevel::Info>(LogCategory::Transaction, "Deposit: Account ID=", account_id, ", Amount=", amount);
+        return true;
+    }
+    logger.log<LogLevel::Error>(LogCategory::Account, "Deposit failed: Invalid Account ID=", account_id);
+    return false;
+}
+
+bool AccountManager::withdraw_locked(int account_id, float amount) {
+    AccountRecord* record = live_record_locked(account_id);
+    if (record != nullptr && reserve_locked(*record, amount)) {
+        install_locked(*record, record->head.load(memory_order_relaxed)->balance - amount, true);
+        logger.log<LogLevel::Info>(LogCategory::Transaction, "Withdrawal: Account ID=", account_id, ", Amount=", amount);
+        return true;
+    }
+    logger.log<LogLevel::Error>(LogCategory::Account, "Withdrawal failed: Insufficient funds or Invalid Account ID=", account_id);
+    return false;
+}
+
+bool AccountManager::transfer_locked(int from_account_id, int to_account_id, float amount) {
+    AccountRecord* from = live_record_locked(from_account_id);
+    AccountRecord* to = live_record_locked(to_account_id);
+    if (from != nullptr && to != nullptr && reserve_locked(*from, amount)) {
+        install_locked(*from, from->head.load(memory_order_relaxed)->balance - amount, true);
+        install_locked(*to, to->head.load(memory_order_relaxed)->balance + amount, true);
+        logger.log<LogLevel::Info>(LogCategory::Transaction, "Transfer: From Account ID=", from_account_id, ", To Account ID=", to_account_id, ", Amount=", amount);
+        return true;
+    }
+    logger.log<LogLevel::Error>(LogCategory::Account, "Transfer failed: Insufficient funds or Invalid Account ID=", from_account_id, " -> ", to_account_id);
+    return false;
+}
+
+float AccountManager::check_balance_locked(int account_id) {
+    AccountRecord* record = live_record_locked(account_id);
+    if (record != nullptr) {
+        fold_locked(*record);
+        return record->head.load(memory_order_relaxed)->balance;
+    }
+    logger.log<LogLevel::Error>(LogCategory::Account, "Check balance failed: Invalid Account ID=", account_id);
+    return -1.0f; // Indicate invalid account
+}
+
+int AccountManager::add_account(int customer_id, float initial_balance) {
+    lock_guard<MonitoredMutex> lock(mtx);
+    int account_id = add_account_locked(customer_id, initial_balance);
+    publish_locked();
+    return account_id;
+}
+
+AccountManager::Account AccountManager::get_account(int account_id) {
+    AccountRecord* record = find_record(account_id);
+    float balance;
+    if (record != nullptr && read_latest(*record, balance)) {
+        return { record->account_id, record->customer_id, balance };
+    }
+    logger.log<LogLevel::Error>(LogCategory::Account, "Get account failed: Invalid Account ID=", account_id);
+    return { -1, -1, -1.0f }; // Indicate invalid account
+}
+
+int AccountManager::customer_of(int account_id) const {
+    AccountRecord* record = find_record(account_id);
+    return record != nullptr && record->live.load(memory_order_acquire) ? record->customer_id : -1;
+}
+
+bool AccountManager::update_balance(int account_id, float new_balance) {
+    lock_guard<MonitoredMutex> lock(mtx);
+    AccountRecord* record = live_record_locked(account_id);
+    if (record != nullptr) {
+        // Fold first so deposits so far are replaced, not added on top
+        fold_locked(*record);
+        install_locked(*record, new_balance, true);
+        publish_locked();
+        logger.log<LogLevel::Audit>(LogCategory::Account, "Balance updated: Account ID=", account_id, ", New Balance=", new_balance);
+        return true;
+    }
+    logger.log<LogLevel::Error>(LogCategory::Account, "Update balance failed: Invalid Account ID=", account_id);
+    return false;
+}
+
+bool AccountManager::delete_account(int account_id) {
+    lock_guard<MonitoredMutex> lock(mtx);
+    AccountRecord* record = live_record_locked(account_id);
+    if (record != nullptr) {
+        Version* head = record->head.load(memory_order_relaxed);
+        float closing = head->balance;
+        HotBalance* hot = record->hot.load(memory_order_relaxed);
+        if (hot != nullptr) {
+            // The final fold: no deposit can land after it; see deposit()
+            closing += static_cast<float>(hot->seal() - head->folded);
+        }
+        install_locked(*record, 0.0f, false);
+        publish_locked();
+        logger.log<LogLevel::Audit>(LogCategory::Account, "Account deleted: ID=", account_id, ", Closing Balance=", closing);
+        return true;
+    }
+    logger.log<LogLevel::Error>(LogCategory::Account, "Delete account failed: Invalid Account ID=", account_id);
+    return false;
+}
+
+bool AccountManager::deposit(int account_id, float amount) {
+    AccountRecord* record = find_record(account_id);
+    HotBalance* hot = record != nullptr ? record->hot.load(memory_order_acquire) : nullptr;
+    if (hot != nullptr) {
+        // Compare-and-swap rather than fetch_add, so that a deposit either
+        // lands before delete_account() seals the stripe, and is in the
+        // closing balance, or sees the seal and is turned away below
+        atomic<double>& stripe = hot->stripes[local_stripe() % HOT_STRIPES].total;
+        double current = stripe.load(memory_order_relaxed);
+        while (!isnan(current) && !stripe.compare_exchange_weak(current, current + amount, memory_order_relaxed)) {
+        }
+        if (!isnan(current)) {
+            logger.log<LogLevel::Info>(LogCategory::Transaction, "Deposit: Account ID=", account_id, ", Amount=", amount);
+            return true;
+        }
+    }
+    lock_guard<MonitoredMutex> lock(mtx);
+    bool ok = deposit_locked(account_id, amount);
+    publish_locked();
+    return ok;
+}
+
+bool AccountManager::withdraw(int account_id, float amount) {
+    lock_guard<MonitoredMutex> lock(mtx);
+    bool ok = withdraw_locked(account_id, amount);
+    publish_locked();
+    return ok;
+}
+
+bool AccountManager::transfer(int from_account_id, int to_account_id, float amount) {
+    lock_guard<MonitoredMutex> lock(mtx);
+    bool ok = transfer_locked(from_account_id, to_account_id, amount);
+    publish_locked();
+    return ok;
+}
+
+float AccountManager::check_balance(int account_id) {
+    AccountRecord* record = find_record(account_id);
+    float balance;
+    if (record != nullptr && read_latest(*record, balance)) {
+        return balance;
+    }
+    logger.log<LogLevel::Error>(LogCategory::Account, "Check balance failed: Invalid Account ID=", account_id);
+    return -1.0f; // Indicate invalid account
+}
+
+void AccountManager::apply_batch(vector<Operation>& ops) {
+    lock_guard<MonitoredMutex> lock(mtx);
+    for (auto& op : ops) {
+        if (op.rejected) {
+            continue;
+        }
+        switch (op.type) {
+        case Operation::CreateAccount:
+            op.result_account_id = add_account_locked(op.account_id, op.amount);
+            op.customer_id = op.account_id;
+            op.ok = op.result_account_id != -1;
+            continue;
+        case Operation::Deposit:
+            op.ok = deposit_locked(op.account_id, op.amount);
+            break;
+        case Operation::Withdraw:
+            op.ok = withdraw_locked(op.account_id, op.amount);
+            break;
+        case Operation::CheckBalance:
+            op.balance = check_balance_locked(op.account_id);
+            op.ok = op.balance >= 0.0f;
+            break;
+        case Operation::Transfer:
+            op.ok = transfer_locked(op.account_id, op.to_account_id, op.amount);
+            break;
+        }
+        AccountRecord* record = find_record(op.account_id);
+        if (record != nullptr) {
+            op.customer_id = record->customer_id;
+        }
+    }
+    publish_locked();
+}
+
+bool AccountManager::transact(const vector<int>& account_ids, const TransactionBody& body) {
+    vector<float> balances, new_balances;
+    if (!run_transaction("Transaction", account_ids, body, balances, new_balances)) {
+        return false;
+    }
+    for (size_t i = 0; i < account_ids.size(); ++i) {
+        logger.log<LogLevel::Info>(LogCategory::Transaction, "Transaction: Account ID=", account_ids[i], ", Amount=", new_balances[i] - balances[i]);
+    }
+    return true;
+}
+
+bool AccountManager::post(const vector<Leg>& legs) {
+    // Money moves between accounts but is never created or destroyed. The
+    // only slack allowed is the rounding of each amount to float.
+    double sum = 0.0, gross = 0.0;
+    for (const Leg& leg : legs) {
+        if (!isfinite(leg.amount)) {
+            transactions_rejected.fetch_add(1, memory_order_relaxed);
+            logger.log<LogLevel::Error>(LogCategory::Account, "Posting failed: Invalid amount for Account ID=", leg.account_id);
+            return false;
+        }
+        sum += leg.amount;
+        gross += fabs(leg.amount);
+    }
+    if (fabs(sum) > numeric_limits<float>::epsilon() * gross) {
+        transactions_rejected.fetch_add(1, memory_order_relaxed);
+        logger.log<LogLevel::Error>(LogCategory::Account, "Posting failed: Legs do not balance, Sum=", sum);
+        return false;
+    }
+
+    // Net the legs per account; an account may be both debited and credited
+    vector<int> account_ids;
+    vector<float> amounts;
+    vector<bool> debited;
+    for (const Leg& leg : legs) {
+        size_t i = find(account_ids.begin(), account_ids.end(), leg.account_id) - account_ids.begin();
+        if (i == account_ids.size()) {
+            account_ids.push_back(leg.account_id);
+            amounts.push_back(0.0f);
+            debited.push_back(false);
+        }
+        amounts[i] += leg.amount;
+        debited[i] = debited[i] || leg.amount < 0.0f;
+    }
+
+    vector<float> balances, new_balances;
+    bool ok = run_transaction("Posting", account_ids, [&](const vector<float>& current, vector<float>& next) {
+        for (size_t i = 0; i < current.size(); ++i) {
+            next[i] = current[i] + amounts[i];
+            if (debited[i] && next[i] < 0.0f) {
+                return false; // Insufficient funds
+            }
+        }
+        return true;
+    }, balances, new_balances);
+    if (!ok) {
+        return false;
+    }
+    for (const Leg& leg : legs) {
+        logger.log<LogLevel::Info>(LogCategory::Transaction, "Posting: Account ID=", leg.account_id, ", Amount=", leg.amount);
+    }
+    return true;
+}
+
+TransactionMetrics AccountManager::transaction_metrics() const {
+    TransactionMetrics metrics;
+    metrics.committed = transactions_committed.load(memory_order_relaxed);
+    metrics.rejected = transactions_rejected.load(memory_order_relaxed);
+    metrics.optimistic_commits = optimistic_commits.load(memory_order_relaxed);
+    metrics.aborts = optimistic_aborts.load(memory_order_relaxed);
+    metrics.locked_commits = locked_commits.load(memory_order_relaxed);
+    metrics.deadlock_aborts = deadlock_aborts.load(memory_order_relaxed);
+    return metrics;
+}
+
+bool AccountManager::promote_hot(int account_id) {
+    lock_guard<MonitoredMutex> lock(mtx);
+    AccountRecord* record = live_record_locked(account_id);
+    if (record != nullptr) {
+        promote_locked(*record);
+        return true;
+    }
+    logger.log<LogLevel::Error>(LogCategory::Account, "Promote account failed: Invalid Account ID=", account_id);
+    return false;
+}
+
+bool AccountManager::is_hot(int account_id) const {
+    AccountRecord* record = find_record(account_id);
+    return record != nullptr && record->hot.load(memory_order_acquire) != nullptr;
+}
+
+AccountManager::BookSnapshot AccountManager::snapshot() {
+    BookSnapshot book;
+    fold_hot();
+    SnapshotRegistry::Reader reader(snapshots);
+    book.commit = reader.commit();
+    int end = next_account_id.load(memory_order_acquire);
+    for (int account_id = 1; account_id < end; ++account_id) {
+        AccountRecord* record = find_record(account_id);
+        Version* version = record == nullptr ? nullptr : visible(*record, book.commit);
+        if (version != nullptr && version->live) {
+            book.accounts.push_back({ record->account_id, record->customer_id, version->balance });
+            book.total_balance += version->balance;
+        }
+    }
+    return book;
+}
+
+AccountManager::BookSnapshot AccountManager::customer_book(int customer_id) {
+    BookSnapshot book;
+    book.commit = visit_customer(customer_id, [&](const AccountRecord& record, float balance) {
+        book.accounts.push_back({ record.account_id, record.customer_id, balance });
+        book.total_balance += balance;
+    });
+    return book;
+}
+
+vector<int> AccountManager::customer_accounts(int customer_id) {
+    vector<int> account_ids;
+    visit_customer(customer_id, [&](const AccountRecord& record, float) { account_ids.push_back(record.account_id); });
+    return account_ids;
+}
+
+double AccountManager::customer_balance(int customer_id) {
+    double total = 0.0;
+    visit_customer(customer_id, [&](const AccountRecord&, float balance) { total += balance; });
+    return total;
+}
+
+size_t AccountManager::collect_garbage() {
+    lock_guard<MonitoredMutex> lock(mtx);
+    return collect_locked();
+}
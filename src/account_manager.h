@@ -0,0 +1,357 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "lock_monitor.h"
+#include "logger.h"
+#include "snapshot_registry.h"
+
+// How multi-account transactions retry
+struct TransactionPolicy {
+    uint32_t optimistic_attempts = 3; // Conflicting attempts before locking for the whole transaction
+};
+
+// When deposit-heavy accounts switch to striped balances
+struct HotAccountPolicy {
+    bool auto_promote = true;
+    uint32_t window_deposits = 4096;  // Deposits per detection window, across all accounts
+    uint32_t promote_deposits = 1024; // Deposits to one account in a window that make it hot
+};
+
+// Outcomes of multi-account transactions since the AccountManager started
+struct TransactionMetrics {
+    uint64_t committed = 0;
+    uint64_t rejected = 0;           // Invalid account, body declined (e.g. insufficient funds) or deadlock victim
+    uint64_t optimistic_commits = 0; // Committed without holding the lock while computing
+    uint64_t aborts = 0;             // Optimistic attempts that failed validation and were retried
+    uint64_t locked_commits = 0;     // Committed on the locked fallback
+    uint64_t deadlock_aborts = 0;    // Locked fallbacks given up as a deadlock victim
+
+    // Share of optimistic attempts that failed validation
+    double abort_rate() const {
+        uint64_t attempts = optimistic_commits + aborts;
+        return attempts == 0 ? 0.0 : static_cast<double>(aborts) / static_cast<double>(attempts);
+    }
+};
+
+// AccountManager class for account operations.
+// Account records are multi-versioned: writers serialize on `mtx` and
+// install a new version of each record they change, stamped with the
+// commit, while book reports read a snapshot without taking the lock.
+// Versions no snapshot can see any more are collected by the writers every
+// COLLECT_INTERVAL new versions. The latest committed balance is also kept
+// in each record under a seqlock, so single-account reads neither lock nor
+// write shared memory; they retry if a commit lands mid-read.
+// Multi-account transactions run optimistically: they read balances and
+// their seqlock sequences without the lock, compute, and commit only if no
+// account changed in between, falling back to holding the lock throughout
+// after TransactionPolicy::optimistic_attempts conflicts.
+// Hot accounts (settlement and fee accounts taking a large share of all
+// deposits) take deposits without the lock into per-thread stripes that
+// latest-balance reads add to the committed balance. The committed balance
+// is the escrow for debits; stripes are folded into it under the lock when
+// a debit needs more than it holds, and before every snapshot, so a
+// snapshot holds exactly the deposits made before it.
+// A sharded index from customer ID to account IDs serves customer-level
+// reads. Accounts join it on creation and leave once no snapshot can see
+// them live any more, so customer reads at a snapshot never miss one.
+class AccountManager {
+public:
+    // Computes new balances from the current ones, in the order of the
+    // transaction's account IDs; returns false to reject the transaction.
+    // May run more than once, so it must not have side effects.
+    using TransactionBody = std::function<bool(const std::vector<float>& balances, std::vector<float>& new_balances)>;
+
+private:
+    struct Account {
+        int account_id;
+        int customer_id;
+        float balance;
+    };
+
+    // One committed state of an account; immutable once its commit is
+    // published
+    struct Version {
+        uint64_t commit = 0;
+        float balance = 0.0f;
+        bool live = true; // False from the commit that deleted the account
+        double folded = 0.0; // Hot deposits already counted in `balance`
+        std::atomic<Version*> older{ nullptr };
+    };
+
+    static constexpr size_t HOT_STRIPES = 16;
+
+    // Deposits to a hot account, striped by thread
+    struct HotBalance {
+        struct alignas(64) Stripe {
+            std::atomic<double> total{ 0.0 }; // NaN once sealed
+        };
+        std::array<Stripe, HOT_STRIPES> stripes;
+
+        double total() const; // NaN once sealed
+
+        // Turn further deposits away and return the total of those made
+        double seal();
+    };
+
+    struct AccountRecord {
+        int account_id;
+        int customer_id;
+        std::atomic<Version*> head{ nullptr }; // Newest version first
+
+        // Latest committed state; `sequence` is odd while a commit updates it
+        std::atomic<uint64_t> sequence{ 0 };
+        std::atomic<float> balance{ 0.0f };
+        std::atomic<bool> live{ false };
+        std::atomic<double> folded{ 0.0 };
+
+        std::atomic<HotBalance*> hot{ nullptr }; // Set once on promotion
+
+        bool collectable = false; // Listed in `versioned`; guarded by mtx
+        bool pending = false;     // Listed in `pending`; guarded by mtx
+
+        // Hot account detection, guarded by mtx
+        uint64_t deposit_window = 0;
+        uint32_t window_deposits = 0;
+    };
+
+    // Records by account ID in fixed chunks, so readers can look them up
+    // while writers add accounts
+    static constexpr size_t CHUNK_ACCOUNTS = 1 << 14;
+    static constexpr size_t MAX_CHUNKS = 1 << 14;
+    using Chunk = std::array<std::atomic<AccountRecord*>, CHUNK_ACCOUNTS>;
+
+    // Account IDs by owner in creation order, including deleted accounts
+    // some snapshot may still see
+    struct CustomerShard {
+        MonitoredMutex mtx{ "AccountManager::customers" };
+        std::unordered_map<int, std::vector<int>> accounts;
+    };
+    static constexpr size_t CUSTOMER_SHARDS = 64;
+
+    std::unique_ptr<std::atomic<Chunk*>[]> chunks;
+    std::atomic<int> next_account_id{ 1 };
+    MonitoredMutex mtx{ "AccountManager" };
+    SnapshotRegistry snapshots;
+    std::array<CustomerShard, CUSTOMER_SHARDS> customers;
+    Logger& logger;
+
+    // Commit and garbage collection state, guarded by mtx
+    std::vector<AccountRecord*> pending;   // Records changed by the pending commit
+    std::vector<AccountRecord*> versioned; // Records with more than one version
+    std::vector<Version*> spare_versions;  // Collected versions for reuse
+    std::vector<AccountRecord*> hot_records; // Promoted records, folded before snapshots
+    size_t versions_since_collect = 0;
+    uint64_t deposits_locked = 0;
+
+    HotAccountPolicy hot_policy;
+    std::atomic<bool> any_hot{ false }; // Snapshots skip the fold (and the lock) until set
+
+    // Multi-account transaction outcomes
+    TransactionPolicy transaction_policy;
+    std::atomic<uint64_t> transactions_committed{ 0 };
+    std::atomic<uint64_t> transactions_rejected{ 0 };
+    std::atomic<uint64_t> optimistic_commits{ 0 };
+    std::atomic<uint64_t> optimistic_aborts{ 0 };
+    std::atomic<uint64_t> locked_commits{ 0 };
+    std::atomic<uint64_t> deadlock_aborts{ 0 };
+
+    AccountRecord* find_record(int account_id) const;
+
+    // Newest version of the record visible at `snapshot`, or nullptr
+    static Version* visible(const AccountRecord& record, uint64_t snapshot);
+
+    // Fold every hot account's stripes into a new commit, so a snapshot
+    // taken afterwards includes all deposits made before the call
+    void fold_hot();
+
+    CustomerShard& customer_shard(int customer_id);
+
+    // Copy of the customer's indexed account IDs
+    std::vector<int> indexed_accounts(int customer_id);
+
+    // Call visit(record, balance) for each of the customer's accounts live
+    // at one snapshot, which is returned
+    template <typename Visit>
+    uint64_t visit_customer(int customer_id, Visit&& visit) {
+        // Snapshot first: accounts are indexed before their creation is
+        // published and unindexed only after their deletion passes every reader
+        fold_hot();
+        SnapshotRegistry::Reader reader(snapshots);
+        for (int account_id : indexed_accounts(customer_id)) {
+            AccountRecord* record = find_record(account_id);
+            Version* version = visible(*record, reader.commit());
+            if (version != nullptr && version->live) {
+                visit(*record, version->balance);
+            }
+        }
+        return reader.commit();
+    }
+
+    // Latest committed balance through the seqlock, with the sequence it was
+    // read at; false if deleted or not yet committed
+    static bool read_latest(const AccountRecord& record, float& balance, uint64_t& sequence);
+    static bool read_latest(const AccountRecord& record, float& balance);
+
+    // Optimistic commit: install `balances` if every account is still at
+    // `sequences`; false on a conflict
+    bool commit_if_unchanged(const std::vector<AccountRecord*>& records, const std::vector<uint64_t>& sequences,
+                             const std::vector<float>& balances);
+
+    // Run a transaction optimistically, then under the lock once conflicts
+    // exhaust the policy's attempts; the locked run gives way if it is picked
+    // as a deadlock victim. Invalid accounts and rejections are logged under
+    // `name`; on success `balances` holds the values replaced.
+    bool run_transaction(const char* name, const std::vector<int>& account_ids, const TransactionBody& body,
+                         std::vector<float>& balances, std::vector<float>& new_balances);
+
+    // The *_locked helpers expect `mtx` to be held by the caller; their
+    // changes become visible to readers on publish_locked()
+
+    // Live record for a write, or nullptr
+    AccountRecord* live_record_locked(int account_id);
+
+    // Count a locked deposit towards hot account detection
+    void note_deposit_locked(AccountRecord& record);
+
+    void promote_locked(AccountRecord& record);
+
+    // Move a hot record's unfolded deposits into its committed balance
+    void fold_locked(AccountRecord& record);
+
+    // Make sure the committed balance covers a debit, folding only if short
+    bool reserve_locked(AccountRecord& record, float amount);
+
+    // Give the record a new balance (or delete it) in the pending commit
+    void install_locked(AccountRecord& record, float balance, bool live);
+
+    // Make the pending commit visible and collect old versions when due
+    void publish_locked();
+
+    size_t collect_locked();
+
+    // Drop a deleted account no snapshot can see from the customer index
+    void unindex_customer_locked(const AccountRecord& record);
+
+    int add_account_locked(int customer_id, float initial_balance);
+
+    bool deposit_locked(int account_id, float amount);
+
+    bool withdraw_locked(int account_id, float amount);
+
+    bool transfer_locked(int from_account_id, int to_account_id, float amount);
+
+    float check_balance_locked(int account_id);
+
+public:
+    static constexpr size_t COLLECT_INTERVAL = 1024;
+
+    // One operation of a batch. Inputs are set by the caller; apply_batch()
+    // fills in the results.
+    struct Operation {
+        enum Type { CreateAccount, Deposit, Withdraw, CheckBalance, Transfer };
+
+        Type type;
+        int account_id;        // customer_id for CreateAccount, source for Transfer
+        int to_account_id;     // Destination for Transfer
+        float amount;
+        uint64_t idempotency_key = 0; // 0 for none; see SystemCallInterface::execute_batch
+        bool rejected = false;        // Set by the caller to skip an operation that failed validation
+
+        bool ok = false;
+        int result_account_id = -1; // Account created by CreateAccount
+        int customer_id = -1;       // Owner of account_id, when it exists
+        float balance = -1.0f;      // Result of CheckBalance
+    };
+
+    // One leg of a posting: a credit (amount > 0) or debit (amount < 0)
+    struct Leg {
+        int account_id;
+        float amount;
+    };
+
+    // Every live account as of one commit
+    struct BookSnapshot {
+        uint64_t commit = 0;
+        std::vector<Account> accounts; // By account ID
+        double total_balance = 0.0;
+    };
+
+    AccountManager(Logger& logger, const TransactionPolicy& transaction_policy = {},
+                   const HotAccountPolicy& hot_policy = {});
+
+    ~AccountManager();
+
+    AccountManager(const AccountManager&) = delete;
+    AccountManager& operator=(const AccountManager&) = delete;
+
+    int add_account(int customer_id, float initial_balance);
+
+    // Reads the latest commit without locking or blocking writers
+    Account get_account(int account_id);
+
+    // Owner of a live account, or -1; unlike get_account() an unknown ID is
+    // not logged, for callers that leave that to their own validation
+    int customer_of(int account_id) const;
+
+    bool update_balance(int account_id, float new_balance);
+
+    bool delete_account(int account_id);
+
+    // Deposits to hot accounts neither lock nor publish a commit
+    bool deposit(int account_id, float amount);
+
+    bool withdraw(int account_id, float amount);
+
+    // Move funds between two accounts atomically under the account lock
+    bool transfer(int from_account_id, int to_account_id, float amount);
+
+    // Reads the latest commit without locking or blocking writers
+    float check_balance(int account_id);
+
+    // Apply a batch of operations in order with a single lock acquisition.
+    // Each operation succeeds or fails on its own; snapshots see the whole
+    // batch or none of it.
+    void apply_batch(std::vector<Operation>& ops);
+
+    // Atomically replace the balances of distinct accounts with those the
+    // body computes; false if an account is invalid or the body rejects
+    bool transact(const std::vector<int>& account_ids, const TransactionBody& body);
+
+    // Apply every leg or none, e.g. a split payment plus its fee; fails if
+    // the legs do not sum to zero, an amount is not finite, an account is
+    // invalid or a debit would overdraw it. An account may appear in
+    // several legs.
+    bool post(const std::vector<Leg>& legs);
+
+    TransactionMetrics transaction_metrics() const;
+
+    // Switch an account to striped deposits ahead of auto-detection
+    bool promote_hot(int account_id);
+
+    bool is_hot(int account_id) const;
+
+    // Consistent view of the whole book for reports, taken while writers
+    // carry on. Hot accounts have their stripes folded in first, which
+    // briefly takes the lock.
+    BookSnapshot snapshot();
+
+    // A customer's live accounts and their total as of one commit
+    BookSnapshot customer_book(int customer_id);
+
+    // IDs of the customer's live accounts, oldest first
+    std::vector<int> customer_accounts(int customer_id);
+
+    // Total balance of the customer's live accounts; 0 if none
+    double customer_balance(int customer_id);
+
+    // Reclaim versions no snapshot can see; returns how many were freed
+    size_t collect_garbage();
+};
@@ -0,0 +1,48 @@
+#include "error_aggregator.h"
+
+using namespace std;
+
+string_view ErrorAggregator::error_type(string_view message) {
+    // "Deposit failed: Invalid Account ID=7" -> "Deposit failed"
+    size_t colon = message.find(':');
+    return colon == string_view::npos ? message : message.substr(0, colon);
+}
+
+bool ErrorAggregator::admit(string_view message, int64_t now_us, string& summary) {
+    int64_t window_us = static_cast<int64_t>(policy.window.count()) * 1000;
+
+    auto repeat = repeats.find(message);
+    if (repeat != repeats.end() && now_us - repeat->second.window_start < window_us) {
+        ++repeat->second.suppressed;
+        return false;
+    }
+
+    string_view type = error_type(message);
+    auto bucket = buckets.find(type);
+    if (bucket == buckets.end() && buckets.size() < policy.max_tracked) {
+        bucket = buckets.emplace(string(type), TypeBucket{ policy.type_burst, now_us, 0 }).first;
+    }
+    TypeBucket& tokens = bucket != buckets.end() ? bucket->second : untracked;
+    tokens.tokens = min(policy.type_burst, tokens.tokens + (now_us - tokens.refilled_at) * policy.type_rate / 1e6);
+    tokens.refilled_at = now_us;
+    if (tokens.tokens < 1.0) {
+        ++tokens.limited;
+        next_sweep = min(next_sweep, now_us + window_us);
+        return false;
+    }
+    tokens.tokens -= 1.0;
+
+    // First occurrence in a new window: write it and start counting repeats,
+    // after the count of the window that expired without a sweep
+    if (repeat != repeats.end()) {
+        if (repeat->second.suppressed != 0) {
+            summary = suppressed_summary(repeat->first, repeat->second.suppressed);
+        }
+        repeat->second = Repeat{ 0, now_us };
+    }
+    else if (repeats.size() < policy.max_tracked) {
+        repeats.emplace(string(message), Repeat{ 0, now_us });
+    }
+    next_sweep = min(next_sweep, now_us + window_us);
+    return true;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// How error storms are folded
+struct ErrorLogPolicy {
+    std::chrono::milliseconds window{ 1000 }; // Identical errors within a window are counted, not written
+    double type_rate = 50.0;                  // Sustained errors per second per type ("Deposit failed", ...)
+    double type_burst = 100.0;                // Bucket size per type
+    size_t max_tracked = 10000;               // Distinct messages tracked per window, and error types with their own bucket
+};
+
+// ErrorAggregator class for deduplicating and rate limiting error records.
+// The first occurrence of a message in a window is written; repeats are
+// counted and reported as one summary line when the window closes. Each error
+// type also has a token bucket, so a storm of distinct messages of one type
+// (e.g. many invalid account IDs) cannot flood the log either. Types beyond
+// max_tracked share one bucket, and a bucket that has refilled is dropped
+// at the next sweep.
+// Not thread-safe: Logger calls it under its error lock.
+class ErrorAggregator {
+private:
+    // Lets the maps be probed with a string_view without allocating
+    struct TextHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view text) const { return std::hash<std::string_view>{}(text); }
+    };
+
+    struct Repeat {
+        uint64_t suppressed = 0;
+        int64_t window_start = 0;
+    };
+
+    struct TypeBucket {
+        double tokens = 0.0;
+        int64_t refilled_at = 0;
+        uint64_t limited = 0; // Dropped since the last summary
+    };
+
+    ErrorLogPolicy policy;
+    std::unordered_map<std::string, Repeat, TextHash, std::equal_to<>> repeats; // By exact message
+    std::unordered_map<std::string, TypeBucket, TextHash, std::equal_to<>> buckets;
+    TypeBucket untracked{ policy.type_burst, 0, 0 }; // Shared by types beyond max_tracked
+    int64_t next_sweep = INT64_MAX;
+
+    static std::string_view error_type(std::string_view message);
+
+    std::string suppressed_summary(const std::string& message, uint64_t suppressed) const {
+        return "Suppressed " + std::to_string(suppressed) + " repeat(s) in " + std::to_string(policy.window.count()) + "ms of: " + message;
+    }
+
+    // Whether the bucket will have refilled completely by `now_us`
+    bool refilled(const TypeBucket& bucket, int64_t now_us) const {
+        return bucket.limited == 0 && bucket.tokens + (now_us - bucket.refilled_at) * policy.type_rate / 1e6 >= policy.type_burst;
+    }
+
+public:
+    explicit ErrorAggregator(const ErrorLogPolicy& policy = {}) : policy(policy) {}
+
+    // Decide whether an error at `now_us` (steady clock) should be written.
+    // If it starts a new window for a message whose repeats were not swept
+    // yet, `summary` receives their summary line, to be written first.
+    bool admit(std::string_view message, int64_t now_us, std::string& summary);
+
+    // Earliest time a summary may be due; INT64_MAX when nothing is pending
+    int64_t sweep_due() const { return next_sweep; }
+
+    // Emit summaries for windows closed by `now_us` as emit(text)
+    template <typename Emit>
+    void sweep(int64_t now_us, Emit&& emit) {
+        int64_t window_us = static_cast<int64_t>(policy.window.count()) * 1000;
+        next_sweep = INT64_MAX;
+        for (auto it = repeats.begin(); it != repeats.end();) {
+            if (now_us - it->second.window_start >= window_us) {
+                if (it->second.suppressed != 0) {
+                    emit(suppressed_summary(it->first, it->second.suppressed));
+                }
+                it = repeats.erase(it);
+            }
+            else {
+                next_sweep = std::min(next_sweep, it->second.window_start + window_us);
+                ++it;
+            }
+        }
+        for (auto it = buckets.begin(); it != buckets.end();) {
+            if (it->second.limited != 0) {
+                emit("Rate limited " + std::to_string(it->second.limited) + " error(s) of type: " + it->first);
+                it->second.limited = 0;
+                ++it;
+            }
+            else if (refilled(it->second, now_us)) {
+                it = buckets.erase(it); // Same as a new bucket
+            }
+            else {
+                ++it;
+            }
+        }
+        if (untracked.limited != 0) {
+            emit("Rate limited " + std::to_string(untracked.limited) + " error(s) of untracked types");
+            untracked.limited = 0;
+        }
+    }
+};
@@ -0,0 +1,26 @@
+#include "error_handler.h"
+
+#include <cmath>
+
+using namespace std;
+
+void ErrorHandler::handle_error(const string& error_message) {
+    logger.log_error(error_message);
+}
+
+bool ErrorHandler::validate_account_id(int account_id, AccountManager& accountManager) {
+    if (accountManager.get_account(account_id).account_id == -1) {
+        handle_error("Invalid Account ID: " + to_string(account_id));
+        return false;
+    }
+    return true;
+}
+
+bool ErrorHandler::validate_amount(float amount) {
+    // NaN and infinity would poison every balance they touch
+    if (!isfinite(amount) || amount <= 0) {
+        handle_error("Invalid amount: " + to_string(amount));
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+
+#include "account_manager.h"
+#include "logger.h"
+
+// Error Handling Module
+class ErrorHandler {
+private:
+    Logger& logger;
+
+public:
+    ErrorHandler(Logger& logger) : logger(logger) {}
+
+    void handle_error(const std::string& error_message);
+
+    bool validate_account_id(int account_id, AccountManager& accountManager);
+
+    bool validate_amount(float amount);
+};
@@ -0,0 +1,79 @@
+#include "executor.h"
+
+#include <algorithm>
+
+using namespace std;
+
+void Executor::worker_loop() {
+    while (true) {
+        function<void()> work;
+        {
+            unique_lock<mutex> lock(mtx);
+            cv.wait(lock, [this] { return !run_queue.empty() || !running; });
+            if (run_queue.empty()) {
+                return;
+            }
+            work = move(run_queue.front());
+            run_queue.pop_front();
+        }
+        work();
+    }
+}
+
+void Executor::task_finished() {
+    lock_guard<mutex> lock(mtx);
+    if (--outstanding_tasks == 0) {
+        idle_cv.notify_all();
+    }
+}
+
+DetachedTask Executor::run_detached(Executor& executor, Task<void> task) {
+    co_await task;
+    executor.task_finished();
+}
+
+Executor::Executor(size_t num_threads) {
+    for (size_t i = 0; i < max<size_t>(num_threads, 1); ++i) {
+        workers.emplace_back(&Executor::worker_loop, this);
+    }
+}
+
+Executor::~Executor() {
+    stop();
+}
+
+void Executor::post(function<void()> work) {
+    lock_guard<mutex> lock(mtx);
+    run_queue.push_back(move(work));
+    cv.notify_one();
+}
+
+void Executor::schedule(coroutine_handle<> handle) {
+    post([handle] { handle.resume(); });
+}
+
+void Executor::spawn(Task<void> task) {
+    {
+        lock_guard<mutex> lock(mtx);
+        outstanding_tasks++;
+    }
+    schedule(run_detached(*this, move(task)).handle);
+}
+
+void Executor::wait_idle() {
+    unique_lock<mutex> lock(mtx);
+    idle_cv.wait(lock, [this] { return outstanding_tasks == 0; });
+}
+
+void Executor::stop() {
+    {
+        lock_guard<mutex> lock(mtx);
+        running = false;
+        cv.notify_all();
+    }
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
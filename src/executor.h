@@ -0,0 +1,61 @@
+#pragma once
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "task.h"
+
+// Executor class: a small thread pool that resumes coroutines. Suspended
+// coroutines cost only their frame, so a few threads can keep tens of
+// thousands of transactions in flight while they wait on IPC or log I/O.
+class Executor {
+private:
+    std::deque<std::function<void()>> run_queue;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::condition_variable idle_cv;
+    std::vector<std::thread> workers;
+    bool running = true;
+    size_t outstanding_tasks = 0; // Spawned tasks that have not finished yet
+
+    void worker_loop();
+
+    void task_finished();
+
+    static DetachedTask run_detached(Executor& executor, Task<void> task);
+
+public:
+    Executor(size_t num_threads = 1);
+
+    ~Executor();
+
+    void post(std::function<void()> work);
+
+    void schedule(std::coroutine_handle<> handle);
+
+    // Awaitable that moves the awaiting coroutine onto this executor
+    auto schedule() {
+        struct ScheduleAwaiter {
+            Executor& executor;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) { executor.schedule(handle); }
+            void await_resume() const noexcept {}
+        };
+        return ScheduleAwaiter{ *this };
+    }
+
+    // Start a task on the executor without waiting for it
+    void spawn(Task<void> task);
+
+    // Block until every spawned task has finished
+    void wait_idle();
+
+    // Finish queued work, then join the worker threads
+    void stop();
+};
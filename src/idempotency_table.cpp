@@ -0,0 +1,135 @@
+#include "idempotency_table.h"
+
+#include <algorithm>
+#include <mutex>
+
+using namespace std;
+
+IdempotencyTable::IdempotencyTable(const IdempotencyPolicy& policy)
+    : policy(policy),
+      tick_ms(max<int64_t>(1, (policy.ttl.count() + static_cast<int64_t>(WHEEL_SLOTS) - 2) / static_cast<int64_t>(WHEEL_SLOTS - 1))),
+      max_shard_keys(max<size_t>(1, policy.max_keys / SHARDS)), epoch(chrono::steady_clock::now()) {}
+
+IdempotencyTable::Shard& IdempotencyTable::shard_for(uint64_t key) {
+    // Fibonacci hashing: clients often use sequential keys
+    return shards[(key * 0x9e3779b97f4a7c15ull) >> 58];
+}
+
+int64_t IdempotencyTable::now_tick() const {
+    return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - epoch).count() / tick_ms;
+}
+
+void IdempotencyTable::expire_locked(Shard& shard, int64_t tick) {
+    if (tick <= shard.tick) {
+        return;
+    }
+    // After a long idle gap every slot is due once
+    for (int64_t t = max(shard.tick + 1, tick - static_cast<int64_t>(WHEEL_SLOTS) + 1); t <= tick; ++t) {
+        vector<uint64_t>& slot = shard.wheel[t % WHEEL_SLOTS];
+        size_t kept = 0;
+        for (uint64_t key : slot) {
+            auto it = shard.entries.find(key);
+            if (it == shard.entries.end()) {
+                continue; // Evicted
+            }
+            // Requests still running keep their key until they complete
+            if (it->second.done && it->second.expires_tick <= tick) {
+                shard.entries.erase(it);
+                continue;
+            }
+            slot[kept++] = key;
+        }
+        slot.resize(kept);
+    }
+    shard.tick = tick;
+}
+
+void IdempotencyTable::evict_locked(Shard& shard) {
+    for (size_t i = 1; i <= WHEEL_SLOTS && shard.entries.size() >= max_shard_keys; ++i) {
+        vector<uint64_t>& slot = shard.wheel[(shard.tick + i) % WHEEL_SLOTS];
+        size_t kept = 0;
+        for (uint64_t key : slot) {
+            auto it = shard.entries.find(key);
+            if (it == shard.entries.end()) {
+                continue;
+            }
+            if (it->second.done) {
+                shard.entries.erase(it);
+                continue;
+            }
+            slot[kept++] = key;
+        }
+        slot.resize(kept);
+    }
+}
+
+IdempotencyTable::Claim IdempotencyTable::begin(uint64_t key, uint64_t fingerprint, int64_t& result) {
+    Shard& shard = shard_for(key);
+    int64_t tick = now_tick();
+    unique_lock<MonitoredMutex> lock(shard.mtx);
+    expire_locked(shard, tick);
+    if (shard.entries.size() >= max_shard_keys && !shard.entries.contains(key)) {
+        evict_locked(shard);
+    }
+    int64_t expires_tick = tick + (policy.ttl.count() + tick_ms - 1) / tick_ms;
+    auto deadline = chrono::steady_clock::now() + policy.wait_timeout;
+    for (;;) {
+        auto [it, inserted] = shard.entries.try_emplace(key, Entry{ fingerprint, 0, expires_tick, false });
+        if (inserted) {
+            shard.wheel[expires_tick % WHEEL_SLOTS].push_back(key);
+            return Claim::New;
+        }
+        if (it->second.fingerprint != fingerprint) {
+            return Claim::Mismatch;
+        }
+        if (it->second.done) {
+            result = it->second.result;
+            duplicate_count.fetch_add(1, memory_order_relaxed);
+            return Claim::Duplicate;
+        }
+        // The first request is still running; its result is the answer
+        ++shard.waiting;
+        bool settled = shard.completed.wait_until(lock, deadline, [&] {
+            auto current = shard.entries.find(key);
+            return current == shard.entries.end() || current->second.done;
+        });
+        --shard.waiting;
+        if (!settled) {
+            return Claim::Busy;
+        }
+    }
+}
+
+void IdempotencyTable::complete(uint64_t key, int64_t result) {
+    Shard& shard = shard_for(key);
+    lock_guard<MonitoredMutex> lock(shard.mtx);
+    auto it = shard.entries.find(key);
+    if (it != shard.entries.end()) {
+        it->second.result = result;
+        it->second.done = true;
+    }
+    if (shard.waiting != 0) {
+        shard.completed.notify_all();
+    }
+}
+
+void IdempotencyTable::abandon(uint64_t key) {
+    Shard& shard = shard_for(key);
+    lock_guard<MonitoredMutex> lock(shard.mtx);
+    auto it = shard.entries.find(key);
+    if (it != shard.entries.end() && !it->second.done) {
+        shard.entries.erase(it); // Its wheel slot skips the missing key
+    }
+    if (shard.waiting != 0) {
+        shard.completed.notify_all();
+    }
+}
+
+size_t IdempotencyTable::size() {
+    size_t total = 0;
+    for (Shard& shard : shards) {
+        lock_guard<MonitoredMutex> lock(shard.mtx);
+        total += shard.entries.size();
+    }
+    return total;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "lock_monitor.h"
+
+// How long and how many idempotency keys are remembered
+struct IdempotencyPolicy {
+    std::chrono::milliseconds ttl{ std::chrono::minutes(10) }; // Retries after this run again
+    size_t max_keys = 1 << 20; // Beyond this the keys closest to expiry are dropped early
+    std::chrono::milliseconds wait_timeout{ std::chrono::seconds(5) }; // Longest a retry waits for the first request
+};
+
+// IdempotencyTable class for deduplicating retried requests.
+// The first request with a key claims it and records its result when done;
+// a retry with the same key gets that result instead of running again, and
+// waits for it (up to the policy's wait_timeout) if the first is still
+// running. Keys live in 64 shards, each
+// a hash map under its own lock with a timer wheel of WHEEL_SLOTS slots
+// spanning the TTL, so expiry costs O(1) per key and needs no thread.
+class IdempotencyTable {
+public:
+    static constexpr size_t SHARDS = 64;
+    static constexpr size_t WHEEL_SLOTS = 64;
+
+    enum class Claim {
+        New,       // Run the request, then complete() the key
+        Duplicate, // `result` holds the first request's outcome
+        Mismatch,  // The key was used for a different request
+        Busy,      // The first request is still running after wait_timeout
+    };
+
+    // Abandons a key claimed with Claim::New unless complete() is called
+    // through it, so a request that unwinds cannot leave its retries waiting
+    class Guard {
+    private:
+        IdempotencyTable& table;
+        uint64_t key;
+        bool held = true;
+
+    public:
+        Guard(IdempotencyTable& table, uint64_t key) : table(table), key(key) {}
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+        ~Guard() {
+            if (held) {
+                table.abandon(key);
+            }
+        }
+
+        void complete(int64_t result) {
+            held = false;
+            table.complete(key, result);
+        }
+    };
+
+private:
+    struct Entry {
+        uint64_t fingerprint; // What the key was first used for
+        int64_t result = 0;
+        int64_t expires_tick = 0;
+        bool done = false;
+    };
+
+    struct Shard {
+        MonitoredMutex mtx{ "IdempotencyTable" };
+        std::condition_variable_any completed;
+        std::unordered_map<uint64_t, Entry> entries;
+        std::array<std::vector<uint64_t>, WHEEL_SLOTS> wheel; // Keys by expiry tick
+        int64_t tick = 0;                                     // Last tick expired up to
+        size_t waiting = 0;                                   // Retries waiting on `completed`
+    };
+
+    const IdempotencyPolicy policy;
+    const int64_t tick_ms;       // Wheel resolution: the TTL spread over the slots
+    const size_t max_shard_keys;
+    const std::chrono::steady_clock::time_point epoch;
+    std::array<Shard, SHARDS> shards;
+    std::atomic<uint64_t> duplicate_count{ 0 };
+
+    Shard& shard_for(uint64_t key);
+
+    int64_t now_tick() const;
+
+    // Drop completed keys of the wheel slots up to `tick`; caller holds the
+    // shard lock
+    void expire_locked(Shard& shard, int64_t tick);
+
+    // Drop the keys due soonest to make room; caller holds the shard lock
+    void evict_locked(Shard& shard);
+
+public:
+    explicit IdempotencyTable(const IdempotencyPolicy& policy = {});
+
+    IdempotencyTable(const IdempotencyTable&) = delete;
+    IdempotencyTable& operator=(const IdempotencyTable&) = delete;
+
+    // Claim `key` for a request identified by `fingerprint`
+    Claim begin(uint64_t key, uint64_t fingerprint, int64_t& result);
+
+    // Record the outcome of a claimed key and release its retries
+    void complete(uint64_t key, int64_t result);
+
+    // Give up a claimed key without a result, e.g. when the request was
+    // turned away before running; the next request with it runs afresh
+    void abandon(uint64_t key);
+
+    // Requests answered from the table since start
+    uint64_t duplicates() const { return duplicate_count.load(std::memory_order_relaxed); }
+
+    size_t size();
+};
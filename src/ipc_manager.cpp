@@ -0,0 +1,337 @@
+#include "ipc_manager.h"
+
+#include <algorithm>
+
+using namespace std;
+
+shared_ptr<IPCManager::Subscriber> IPCManager::find_subscriber(int subscriber_id) {
+    lock_guard<MonitoredMutex> lock(sub_mtx);
+    auto it = subscribers.find(subscriber_id);
+    return it != subscribers.end() ? it->second : nullptr;
+}
+
+bool IPCManager::has_topic(const Message& message, const string& topic) {
+    return find(message.topics.begin(), message.topics.end(), topic) != message.topics.end();
+}
+
+void IPCManager::enqueue_dispatch(const shared_ptr<const MessageHandler>& callback, const MessagePtr& message) {
+    lock_guard<MonitoredMutex> lock(loop_mtx);
+    dispatch_queue.push_back({ callback, message });
+    loop_cv.notify_one();
+}
+
+void IPCManager::deliver(Subscriber& subscriber, const MessagePtr& message) {
+    MessageHandler waiter;
+    shared_ptr<const MessageHandler> callback;
+    {
+        lock_guard<MonitoredMutex> lock(subscriber.mtx);
+        if (subscriber.closed) {
+            return;
+        }
+        if (!subscriber.waiters.empty()) {
+            waiter = move(subscriber.waiters.front());
+            subscriber.waiters.pop_front();
+        }
+        else if (subscriber.callback) {
+            callback = subscriber.callback;
+        }
+        else {
+            subscriber.inbox.push_back(message);
+            // receive() and receive_topic() wait on different predicates, so
+            // waking only one could wake one that cannot take the message
+            subscriber.cv.notify_all();
+            return;
+        }
+    }
+    // Handlers run outside the mailbox lock so they may call back into IPCManager
+    if (waiter) {
+        waiter(message);
+    }
+    else {
+        enqueue_dispatch(callback, message);
+    }
+}
+
+IPCManager::~IPCManager() {
+    stop_event_loop();
+}
+
+void IPCManager::send_message(const string& message) {
+    lock_guard<MonitoredMutex> lock(mtx);
+    // Hand the message straight to the oldest waiting future, if any
+    if (!pending_receivers.empty()) {
+        pending_receivers.front().set_value(message);
+        pending_receivers.pop_front();
+        return;
+    }
+    message_queue.push(message);
+    cv.notify_one();
+}
+
+string IPCManager::receive_message(bool blocking) {
+    unique_lock<MonitoredMutex> lock(mtx);
+    if (blocking) {
+        cv.wait(lock, [this] { return !message_queue.empty(); });
+    }
+    else {
+        if (message_queue.empty()) {
+            return "";
+        }
+    }
+    string message = message_queue.front();
+    message_queue.pop();
+    return message;
+}
+
+string IPCManager::receive_for(chrono::milliseconds timeout) {
+    unique_lock<MonitoredMutex> lock(mtx);
+    if (!cv.wait_for(lock, timeout, [this] { return !message_queue.empty(); })) {
+        return "";
+    }
+    string message = message_queue.front();
+    message_queue.pop();
+    return message;
+}
+
+future<string> IPCManager::receive_async() {
+    lock_guard<MonitoredMutex> lock(mtx);
+    promise<string> receiver;
+    future<string> result = receiver.get_future();
+    if (!message_queue.empty()) {
+        receiver.set_value(message_queue.front());
+        message_queue.pop();
+    }
+    else {
+        pending_receivers.push_back(move(receiver));
+    }
+    return result;
+}
+
+int IPCManager::subscribe(const vector<string>& topics) {
+    auto subscriber = make_shared<Subscriber>();
+    subscriber->topics = topics;
+
+    lock_guard<MonitoredMutex> lock(sub_mtx);
+    int subscriber_id = next_subscriber_id++;
+    subscribers[subscriber_id] = subscriber;
+    for (const auto& topic : topics) {
+        topic_subscribers[topic].push_back(subscriber);
+    }
+    return subscriber_id;
+}
+
+int IPCManager::subscribe(const string& topic) {
+    return subscribe(vector<string>{ topic });
+}
+
+bool IPCManager::unsubscribe(int subscriber_id) {
+    shared_ptr<Subscriber> subscriber;
+    {
+        lock_guard<MonitoredMutex> lock(sub_mtx);
+        auto it = subscribers.find(subscriber_id);
+        if (it == subscribers.end()) {
+            return false;
+        }
+        subscriber = it->second;
+        subscribers.erase(it);
+        for (const auto& topic : subscriber->topics) {
+            auto& list = topic_subscribers[topic];
+            list.erase(remove(list.begin(), list.end(), subscriber), list.end());
+            if (list.empty()) {
+                topic_subscribers.erase(topic);
+            }
+        }
+    }
+    deque<MessageHandler> waiters;
+    {
+        lock_guard<MonitoredMutex> lock(subscriber->mtx);
+        subscriber->closed = true;
+        subscriber->callback = nullptr;
+        waiters.swap(subscriber->waiters);
+        subscriber->cv.notify_all();
+    }
+    for (auto& waiter : waiters) {
+        waiter(nullptr);
+    }
+    return true;
+}
+
+size_t IPCManager::publish(const vector<string>& topics, const string& payload) {
+    vector<shared_ptr<Subscriber>> targets;
+    {
+        // Only the routing lookup happens under the subscription lock
+        lock_guard<MonitoredMutex> lock(sub_mtx);
+        for (const auto& topic : topics) {
+            auto it = topic_subscribers.find(topic);
+            if (it != topic_subscribers.end()) {
+                targets.insert(targets.end(), it->second.begin(), it->second.end());
+            }
+        }
+        auto all = topic_subscribers.find(ALL_TOPICS);
+        if (all != topic_subscribers.end()) {
+            targets.insert(targets.end(), all->second.begin(), all->second.end());
+        }
+    }
+    if (targets.empty()) {
+        return 0;
+    }
+    sort(targets.begin(), targets.end());
+    targets.erase(unique(targets.begin(), targets.end()), targets.end());
+
+    MessagePtr message = make_shared<const Message>(Message{ topics, payload });
+    for (const auto& subscriber : targets) {
+        deliver(*subscriber, message);
+    }
+    return targets.size();
+}
+
+size_t IPCManager::publish(const string& topic, const string& payload) {
+    return publish(vector<string>{ topic }, payload);
+}
+
+IPCManager::MessagePtr IPCManager::receive(int subscriber_id, bool blocking) {
+    auto subscriber = find_subscriber(subscriber_id);
+    if (!subscriber) {
+        return nullptr;
+    }
+    unique_lock<MonitoredMutex> lock(subscriber->mtx);
+    if (blocking) {
+        subscriber->cv.wait(lock, [&] { return !subscriber->inbox.empty() || subscriber->closed; });
+    }
+    if (subscriber->inbox.empty()) {
+        return nullptr;
+    }
+    MessagePtr message = subscriber->inbox.front();
+    subscriber->inbox.pop_front();
+    return message;
+}
+
+IPCManager::MessagePtr IPCManager::receive_for(int subscriber_id, chrono::milliseconds timeout) {
+    auto subscriber = find_subscriber(subscriber_id);
+    if (!subscriber) {
+        return nullptr;
+    }
+    unique_lock<MonitoredMutex> lock(subscriber->mtx);
+    subscriber->cv.wait_for(lock, timeout, [&] { return !subscriber->inbox.empty() || subscriber->closed; });
+    if (subscriber->inbox.empty()) {
+        return nullptr;
+    }
+    MessagePtr message = subscriber->inbox.front();
+    subscriber->inbox.pop_front();
+    return message;
+}
+
+bool IPCManager::receive_async(int subscriber_id, MessageHandler handler) {
+    auto subscriber = find_subscriber(subscriber_id);
+    if (!subscriber) {
+        handler(nullptr);
+        return false;
+    }
+    MessagePtr message;
+    {
+        lock_guard<MonitoredMutex> lock(subscriber->mtx);
+        if (subscriber->inbox.empty() && !subscriber->closed) {
+            subscriber->waiters.push_back(move(handler));
+            return true;
+        }
+        if (!subscriber->inbox.empty()) {
+            message = subscriber->inbox.front();
+            subscriber->inbox.pop_front();
+        }
+    }
+    handler(message);
+    return true;
+}
+
+future<IPCManager::MessagePtr> IPCManager::receive_async(int subscriber_id) {
+    auto receiver = make_shared<promise<MessagePtr>>();
+    future<MessagePtr> result = receiver->get_future();
+    receive_async(subscriber_id, [receiver](MessagePtr message) { receiver->set_value(message); });
+    return result;
+}
+
+bool IPCManager::on_message(int subscriber_id, MessageHandler callback) {
+    auto subscriber = find_subscriber(subscriber_id);
+    if (!subscriber) {
+        return false;
+    }
+    deque<MessagePtr> backlog;
+    shared_ptr<const MessageHandler> handler;
+    {
+        lock_guard<MonitoredMutex> lock(subscriber->mtx);
+        if (!callback) {
+            subscriber->callback = nullptr;
+            return true;
+        }
+        handler = make_shared<const MessageHandler>(move(callback));
+        subscriber->callback = handler;
+        backlog.swap(subscriber->inbox);
+    }
+    for (const auto& message : backlog) {
+        enqueue_dispatch(handler, message);
+    }
+    return true;
+}
+
+IPCManager::MessagePtr IPCManager::receive_topic(int subscriber_id, const string& topic, bool blocking) {
+    auto subscriber = find_subscriber(subscriber_id);
+    if (!subscriber) {
+        return nullptr;
+    }
+    unique_lock<MonitoredMutex> lock(subscriber->mtx);
+    auto match = subscriber->inbox.end();
+    auto find_match = [&] {
+        match = find_if(subscriber->inbox.begin(), subscriber->inbox.end(),
+            [&](const MessagePtr& m) { return has_topic(*m, topic); });
+        return match != subscriber->inbox.end();
+    };
+    if (blocking) {
+        subscriber->cv.wait(lock, [&] { return find_match() || subscriber->closed; });
+    }
+    else {
+        find_match();
+    }
+    if (match == subscriber->inbox.end()) {
+        return nullptr;
+    }
+    MessagePtr message = *match;
+    subscriber->inbox.erase(match);
+    return message;
+}
+
+size_t IPCManager::poll_events(size_t max_events) {
+    size_t handled = 0;
+    while (handled < max_events) {
+        Dispatch next;
+        {
+            lock_guard<MonitoredMutex> lock(loop_mtx);
+            if (dispatch_queue.empty()) {
+                break;
+            }
+            next = move(dispatch_queue.front());
+            dispatch_queue.pop_front();
+        }
+        (*next.callback)(next.message);
+        handled++;
+    }
+    return handled;
+}
+
+void IPCManager::run_event_loop() {
+    while (true) {
+        {
+            unique_lock<MonitoredMutex> lock(loop_mtx);
+            loop_cv.wait(lock, [this] { return !dispatch_queue.empty() || !loop_running; });
+            if (!loop_running && dispatch_queue.empty()) {
+                break;
+            }
+        }
+        poll_events();
+    }
+}
+
+void IPCManager::stop_event_loop() {
+    lock_guard<MonitoredMutex> lock(loop_mtx);
+    loop_running = false;
+    loop_cv.notify_all();
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "lock_monitor.h"
+
+// IPCManager class for message queue handling
+class IPCManager {
+public:
+    // A published message. One instance is shared by every subscriber it is
+    // delivered to, so fan-out never copies the payload.
+    struct Message {
+        std::vector<std::string> topics;
+        std::string payload;
+    };
+    using MessagePtr = std::shared_ptr<const Message>;
+    using MessageHandler = std::function<void(MessagePtr)>;
+
+    // Topic that receives every published message (e.g. for auditing)
+    static constexpr const char* ALL_TOPICS = "*";
+
+    static std::string account_topic(int account_id) { return "account/" + std::to_string(account_id); }
+    static std::string customer_topic(int customer_id) { return "customer/" + std::to_string(customer_id); }
+    static std::string event_topic(const std::string& event_type) { return "event/" + event_type; }
+
+private:
+    // Mailbox of a single subscriber; only holds messages for its topics
+    struct Subscriber {
+        std::deque<MessagePtr> inbox;
+        std::deque<MessageHandler> waiters;             // One-shot async receivers, oldest first
+        std::shared_ptr<const MessageHandler> callback; // Dispatched by the event loop when set
+        std::vector<std::string> topics;
+        bool closed = false;
+        MonitoredMutex mtx{ "IPCManager::subscriber" };
+        std::condition_variable_any cv;
+    };
+
+    // A callback invocation waiting for the event loop
+    struct Dispatch {
+        std::shared_ptr<const MessageHandler> callback;
+        MessagePtr message;
+    };
+
+    std::queue<std::string> message_queue;
+    std::deque<std::promise<std::string>> pending_receivers; // Futures waiting on the legacy queue
+    MonitoredMutex mtx{ "IPCManager" };
+    std::condition_variable_any cv;
+
+    std::map<std::string, std::vector<std::shared_ptr<Subscriber>>> topic_subscribers; // topic -> subscribers
+    std::map<int, std::shared_ptr<Subscriber>> subscribers;
+    MonitoredMutex sub_mtx{ "IPCManager::subscribers" };
+    int next_subscriber_id = 1;
+
+    std::deque<Dispatch> dispatch_queue;
+    MonitoredMutex loop_mtx{ "IPCManager::event_loop" };
+    std::condition_variable_any loop_cv;
+    bool loop_running = true;
+
+    std::shared_ptr<Subscriber> find_subscriber(int subscriber_id);
+
+    static bool has_topic(const Message& message, const std::string& topic);
+
+    void enqueue_dispatch(const std::shared_ptr<const MessageHandler>& callback, const MessagePtr& message);
+
+    // Hand a message to a subscriber: a pending async receiver takes priority,
+    // then a registered callback, otherwise it waits in the mailbox
+    void deliver(Subscriber& subscriber, const MessagePtr& message);
+
+public:
+    ~IPCManager();
+
+    void send_message(const std::string& message);
+
+    std::string receive_message(bool blocking = true);
+
+    // Wait up to `timeout` for a message; returns an empty string on timeout
+    std::string receive_for(std::chrono::milliseconds timeout);
+
+    // Returns a future fulfilled by the next message sent, without parking a thread
+    std::future<std::string> receive_async();
+
+    // Register interest in a set of topics; returns the subscriber ID
+    int subscribe(const std::vector<std::string>& topics);
+
+    int subscribe(const std::string& topic);
+
+    // Remove a subscriber, wake any thread blocked on its mailbox and complete
+    // any pending async receivers with nullptr
+    bool unsubscribe(int subscriber_id);
+
+    // Deliver a message to every subscriber of any of its topics. A subscriber
+    // matching several topics still receives the message once. Returns the
+    // number of subscribers the message was delivered to.
+    size_t publish(const std::vector<std::string>& topics, const std::string& payload);
+
+    size_t publish(const std::string& topic, const std::string& payload);
+
+    // Receive the next message for a subscriber. Returns nullptr if the
+    // mailbox is empty (non-blocking), or the subscriber does not exist.
+    MessagePtr receive(int subscriber_id, bool blocking = true);
+
+    // Wait up to `timeout` for the next message; returns nullptr on timeout
+    MessagePtr receive_for(int subscriber_id, std::chrono::milliseconds timeout);
+
+    // One-shot async receive: `handler` gets the next message for this
+    // subscriber (nullptr if it is unsubscribed). It runs immediately if a
+    // message is already queued, otherwise on the publishing thread, so it
+    // should only hand the message off (e.g. fulfil a promise, resume a task).
+    bool receive_async(int subscriber_id, MessageHandler handler);
+
+    // Returns a future fulfilled by the subscriber's next message
+    std::future<MessagePtr> receive_async(int subscriber_id);
+
+    // Register a callback run by the event loop for every message delivered to
+    // this subscriber; already queued messages are dispatched too. Passing an
+    // empty callback returns the subscriber to mailbox delivery.
+    bool on_message(int subscriber_id, MessageHandler callback);
+
+    // Selective receive: take the oldest message carrying the given topic,
+    // leaving other messages queued in their original order
+    MessagePtr receive_topic(int subscriber_id, const std::string& topic, bool blocking = true);
+
+    // Run queued callbacks on the calling thread without blocking; returns
+    // the number of callbacks run
+    size_t poll_events(size_t max_events = SIZE_MAX);
+
+    // Event loop: sleeps until callbacks are queued and runs them, until
+    // stop_event_loop() is called. Remaining callbacks are drained on exit.
+    void run_event_loop();
+
+    void stop_event_loop();
+};
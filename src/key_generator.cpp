@@ -0,0 +1,21 @@
+#include "key_generator.h"
+
+using namespace std;
+
+double KeyGenerator::zeta(uint64_t count, double theta) {
+    double sum = 0;
+    for (uint64_t i = 1; i <= count; ++i) {
+        sum += 1.0 / pow(static_cast<double>(i), theta);
+    }
+    return sum;
+}
+
+KeyGenerator::KeyGenerator(Distribution distribution, uint64_t n, double theta, double hot_fraction, double hot_probability)
+    : distribution(distribution), n(max<uint64_t>(n, 1)), theta(theta), alpha(0), zetan(0), eta(0),
+      hot_keys(max<uint64_t>(1, static_cast<uint64_t>(hot_fraction * n))), hot_probability(hot_probability) {
+    if (distribution == Zipfian) {
+        zetan = zeta(this->n, theta);
+        alpha = 1.0 / (1.0 - theta);
+        eta = (1.0 - pow(2.0 / this->n, 1.0 - theta)) / (1.0 - zeta(2, theta) / zetan);
+    }
+}
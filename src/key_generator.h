@@ -0,0 +1,54 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+// KeyGenerator class: picks account indexes in [0, n) with a uniform,
+// Zipfian (YCSB-style, low indexes hottest) or hot-set distribution
+class KeyGenerator {
+public:
+    enum Distribution { Uniform, Zipfian, HotSet };
+
+private:
+    Distribution distribution;
+    uint64_t n;
+    double theta, alpha, zetan, eta;   // Zipfian parameters
+    uint64_t hot_keys;                 // HotSet: size of the hot set
+    double hot_probability;            // HotSet: share of operations hitting it
+    std::uniform_real_distribution<double> unit{ 0.0, 1.0 };
+
+    static double zeta(uint64_t count, double theta);
+
+public:
+    KeyGenerator(Distribution distribution, uint64_t n, double theta = 0.99, double hot_fraction = 0.01, double hot_probability = 0.9);
+
+    template <typename Rng>
+    uint64_t next(Rng& rng) {
+        double u = unit(rng);
+        switch (distribution) {
+        case Zipfian: {
+            double uz = u * zetan;
+            if (uz < 1.0) {
+                return 0;
+            }
+            if (uz < 1.0 + std::pow(0.5, theta)) {
+                return std::min<uint64_t>(1, n - 1);
+            }
+            return std::min<uint64_t>(n - 1, static_cast<uint64_t>(n * std::pow(eta * u - eta + 1.0, alpha)));
+        }
+        case HotSet:
+            if (hot_keys >= n) {
+                return static_cast<uint64_t>(unit(rng) * n) % n;
+            }
+            if (u < hot_probability) {
+                return static_cast<uint64_t>(unit(rng) * hot_keys) % hot_keys;
+            }
+            return hot_keys + static_cast<uint64_t>(unit(rng) * (n - hot_keys)) % (n - hot_keys);
+        case Uniform:
+        default:
+            return static_cast<uint64_t>(u * n) % n;
+        }
+    }
+};
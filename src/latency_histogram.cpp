@@ -0,0 +1,71 @@
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+size_t LatencyHistogram::index_of(uint64_t value) {
+    if (value < 2 * SUB_BUCKETS) {
+        return static_cast<size_t>(value);
+    }
+    int exponent = 63 - __builtin_clzll(value); // value in [2^exponent, 2^(exponent+1))
+    if (exponent > MAX_EXPONENT) {
+        exponent = MAX_EXPONENT;
+        value = (2ull << MAX_EXPONENT) - 1;
+    }
+    int shift = exponent - SUB_BUCKET_BITS;
+    return 2 * SUB_BUCKETS + (exponent - SUB_BUCKET_BITS - 1) * SUB_BUCKETS + ((value >> shift) - SUB_BUCKETS);
+}
+
+uint64_t LatencyHistogram::highest_value_at(size_t index) {
+    if (index < 2 * SUB_BUCKETS) {
+        return index;
+    }
+    size_t offset = index - 2 * SUB_BUCKETS;
+    int shift = static_cast<int>(offset / SUB_BUCKETS) + 1;
+    uint64_t sub_bucket = SUB_BUCKETS + offset % SUB_BUCKETS;
+    return ((sub_bucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t value_ns) {
+    counts[index_of(value_ns)]++;
+    total++;
+    sum += static_cast<double>(value_ns);
+    max_value = std::max(max_value, value_ns);
+}
+
+void LatencyHistogram::record_corrected(uint64_t value_ns, uint64_t expected_interval_ns) {
+    record(value_ns);
+    if (expected_interval_ns == 0) {
+        return;
+    }
+    for (uint64_t missed = value_ns; missed > expected_interval_ns;) {
+        missed -= expected_interval_ns;
+        record(missed);
+    }
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < counts.size(); ++i) {
+        counts[i] += other.counts[i];
+    }
+    total += other.total;
+    sum += other.sum;
+    max_value = std::max(max_value, other.max_value);
+}
+
+uint64_t LatencyHistogram::percentile(double p) const {
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(ceil(p / 100.0 * total)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= target) {
+            return min(highest_value_at(i), max_value);
+        }
+    }
+    return max_value;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Load Generation Module
+// LatencyHistogram class: HDR-style log-linear histogram of nanosecond
+// latencies. Values below 2048ns are exact; above that every power-of-two
+// range is split into 1024 buckets, so percentiles are within ~0.1%.
+class LatencyHistogram {
+private:
+    static constexpr int SUB_BUCKET_BITS = 10;
+    static constexpr uint64_t SUB_BUCKETS = 1ull << SUB_BUCKET_BITS;
+    static constexpr int MAX_EXPONENT = 42; // ~73 minutes; larger values are clamped
+
+    std::vector<uint64_t> counts;
+    uint64_t total = 0;
+    uint64_t max_value = 0;
+    double sum = 0;
+
+    static size_t index_of(uint64_t value);
+
+    // Largest value that maps to the bucket at `index`
+    static uint64_t highest_value_at(size_t index);
+
+public:
+    LatencyHistogram() : counts(2 * SUB_BUCKETS + (MAX_EXPONENT - SUB_BUCKET_BITS) * SUB_BUCKETS, 0) {}
+
+    void record(uint64_t value_ns);
+
+    // Coordinated-omission correction for a paced closed loop: a response that
+    // took longer than the send interval delayed the requests behind it, so
+    // record the latencies those requests would have seen as well
+    void record_corrected(uint64_t value_ns, uint64_t expected_interval_ns);
+
+    void merge(const LatencyHistogram& other);
+
+    uint64_t count() const { return total; }
+    uint64_t maximum() const { return max_value; }
+    double mean() const { return total ? sum / total : 0.0; }
+
+    uint64_t percentile(double p) const;
+};
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "key_generator.h"
+#include "latency_histogram.h"
+
+struct LoadOptions {
+    std::string target = "inproc"; // inproc, tcp or unix
+    uint16_t port = 7070;
+    std::string unix_path = "/tmp/banking.sock";
+    size_t threads = 4;
+    size_t accounts = 1000;
+    double duration_s = 10.0;
+    double rate = 0;          // Total target ops/s; 0 = as fast as possible (closed loop only)
+    bool open_loop = false;
+    KeyGenerator::Distribution distribution = KeyGenerator::Uniform;
+    double zipf_theta = 0.99;
+    double hot_fraction = 0.01;
+    double hot_probability = 0.9;
+    double mix[4] = { 40, 30, 20, 10 }; // deposit, withdraw, check_balance, transfer weights
+};
+
+struct LoadWorkerResult {
+    LatencyHistogram latency;      // Measured from the intended send time (CO-corrected)
+    LatencyHistogram service_time; // Measured from the actual send time
+    uint64_t operations = 0;
+    uint64_t failures = 0;
+};
+
+// Drive one worker against `target` (a SystemCallInterface or a
+// TransactionClient) until the deadline. Open loop: requests are scheduled on
+// a fixed timetable and latency counts from the scheduled time, so a stalled
+// server is charged for every request it delayed. Closed loop: each request
+// waits for the previous one; with a target rate, missing samples are
+// back-filled by LatencyHistogram::record_corrected.
+template <typename Target>
+void run_load_worker(Target& target, const LoadOptions& options, const std::vector<int>& account_ids,
+                     size_t worker_index, std::chrono::steady_clock::time_point start, LoadWorkerResult& result) {
+    std::mt19937_64 rng(0x5eed + worker_index);
+    KeyGenerator keys(options.distribution, account_ids.size(), options.zipf_theta, options.hot_fraction, options.hot_probability);
+    std::discrete_distribution<int> pick_op(std::begin(options.mix), std::end(options.mix));
+    auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(options.duration_s));
+    std::chrono::nanoseconds interval(0);
+    if (options.rate > 0) {
+        interval = std::chrono::nanoseconds(static_cast<int64_t>(1e9 * options.threads / options.rate));
+    }
+    // Stagger workers so paced requests do not arrive in lockstep
+    auto intended = start + interval * static_cast<int64_t>(worker_index) / static_cast<int64_t>(options.threads);
+
+    while (true) {
+        auto now = std::chrono::steady_clock::now();
+        if (interval.count() > 0) {
+            if (intended >= deadline) {
+                break;
+            }
+            if (intended > now) {
+                // sleep_until overshoots by tens of microseconds; spin the last stretch
+                auto spin_from = intended - std::chrono::microseconds(100);
+                if (spin_from > now) {
+                    std::this_thread::sleep_until(spin_from);
+                }
+                while (std::chrono::steady_clock::now() < intended) {
+                    std::this_thread::yield();
+                }
+                now = std::chrono::steady_clock::now();
+            }
+        }
+        else if (now >= deadline) {
+            break;
+        }
+
+        int account_id = account_ids[keys.next(rng)];
+        bool ok = true;
+        switch (pick_op(rng)) {
+        case 0:
+            ok = target.deposit(account_id, 10.0f);
+            break;
+        case 1:
+            ok = target.withdraw(account_id, 10.0f);
+            break;
+        case 2:
+            ok = target.check_balance(account_id) >= 0.0f;
+            break;
+        default: {
+            int to_account_id = account_ids[keys.next(rng)];
+            if (to_account_id == account_id) {
+                to_account_id = account_ids[(keys.next(rng) + 1) % account_ids.size()];
+            }
+            ok = to_account_id == account_id || target.transfer(account_id, to_account_id, 5.0f);
+            break;
+        }
+        }
+        auto done = std::chrono::steady_clock::now();
+
+        uint64_t service_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(done - now).count();
+        result.service_time.record(service_ns);
+        if (options.open_loop) {
+            result.latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(done - intended).count());
+        }
+        else {
+            result.latency.record_corrected(service_ns, interval.count());
+        }
+        result.operations++;
+        if (!ok) {
+            result.failures++;
+        }
+        // Closed loop never queues up behind itself: the next slot starts
+        // no earlier than now. Open loop keeps the timetable regardless.
+        intended = options.open_loop ? intended + interval : std::max(intended + interval, done);
+    }
+}
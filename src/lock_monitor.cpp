@@ -0,0 +1,218 @@
+#include "lock_monitor.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <sstream>
+
+#include "logger.h"
+
+using namespace std;
+
+namespace {
+
+atomic<uint64_t> next_thread_number{ 1 };
+
+// Longest chain of waiting threads followed from one waiter
+constexpr size_t MAX_CYCLE_LENGTH = 64;
+
+// Lock profiles by name; built on first use so locks with static storage
+// can register too
+struct StatsRegistry {
+    mutex mtx;
+    map<string, unique_ptr<LockStats>> locks;
+};
+
+StatsRegistry& stats_registry() {
+    static StatsRegistry registry;
+    return registry;
+}
+
+}
+
+atomic<Logger*> LockMonitor::logger{ nullptr };
+atomic<uint64_t> LockMonitor::deadlock_count{ 0 };
+DeadlockPolicy LockMonitor::policy;
+mutex LockMonitor::graph_mtx;
+atomic<bool> LockMonitor::profiling_enabled{ false };
+
+void LockTimeHistogram::record(uint64_t value_ns) {
+    buckets[min<size_t>(bit_width(value_ns), buckets.size() - 1)].fetch_add(1, memory_order_relaxed);
+    total_ns.fetch_add(value_ns, memory_order_relaxed);
+}
+
+uint64_t LockTimeHistogram::count() const {
+    uint64_t sum = 0;
+    for (const auto& bucket : buckets) {
+        sum += bucket.load(memory_order_relaxed);
+    }
+    return sum;
+}
+
+uint64_t LockTimeHistogram::percentile(double p) const {
+    uint64_t total = count();
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(p / 100.0 * static_cast<double>(total - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i].load(memory_order_relaxed);
+        if (seen >= rank) {
+            return i == 0 ? 0 : (1ull << i) - 1;
+        }
+    }
+    return UINT64_MAX;
+}
+
+LockMonitor::Waiter::Waiter() : thread_number(next_thread_number.fetch_add(1, memory_order_relaxed)) {}
+
+LockMonitor::Waiter::~Waiter() {
+    // Wait out any walk that may have reached this thread
+    lock_guard<mutex> lock(graph_mtx);
+}
+
+void LockMonitor::set_logger(Logger* new_logger) {
+    logger.store(new_logger, memory_order_release);
+}
+
+void LockMonitor::set_policy(const DeadlockPolicy& new_policy) {
+    policy = new_policy;
+}
+
+LockStats& LockMonitor::stats_for(const string& name) {
+    StatsRegistry& registry = stats_registry();
+    lock_guard<mutex> lock(registry.mtx);
+    unique_ptr<LockStats>& stats = registry.locks[name];
+    if (!stats) {
+        stats = make_unique<LockStats>(name);
+    }
+    return *stats;
+}
+
+string LockMonitor::contention_report() {
+    vector<const LockStats*> locks;
+    {
+        StatsRegistry& registry = stats_registry();
+        lock_guard<mutex> lock(registry.mtx);
+        for (const auto& entry : registry.locks) {
+            locks.push_back(entry.second.get());
+        }
+    }
+    sort(locks.begin(), locks.end(), [](const LockStats* a, const LockStats* b) { return a->wait.total() > b->wait.total(); });
+
+    ostringstream report;
+    char line[256];
+    snprintf(line, sizeof(line), "%-24s %12s %10s %8s %10s %10s %10s %10s %12s\n", "Lock", "acquisitions", "contended",
+             "percent", "wait_p50", "wait_p99", "hold_p50", "hold_p99", "wait_ms");
+    report << line;
+    for (const LockStats* stats : locks) {
+        uint64_t acquisitions = stats->acquisitions.load(memory_order_relaxed);
+        uint64_t contended = stats->contended.load(memory_order_relaxed);
+        snprintf(line, sizeof(line), "%-24s %12llu %10llu %7.2f%% %10llu %10llu %10llu %10llu %12.3f\n",
+                 stats->name.c_str(), static_cast<unsigned long long>(acquisitions),
+                 static_cast<unsigned long long>(contended),
+                 acquisitions == 0 ? 0.0 : 100.0 * static_cast<double>(contended) / static_cast<double>(acquisitions),
+                 static_cast<unsigned long long>(stats->wait.percentile(50)),
+                 static_cast<unsigned long long>(stats->wait.percentile(99)),
+                 static_cast<unsigned long long>(stats->hold.percentile(50)),
+                 static_cast<unsigned long long>(stats->hold.percentile(99)),
+                 static_cast<double>(stats->wait.total()) / 1e6);
+        report << line;
+    }
+    return report.str();
+}
+
+vector<LockMonitor::CycleEdge> LockMonitor::find_cycle(Waiter& self) {
+    lock_guard<mutex> lock(graph_mtx);
+    vector<CycleEdge> cycle;
+    Waiter* current = &self;
+    while (cycle.size() < MAX_CYCLE_LENGTH) {
+        MonitoredMutex* waited = current->waiting_for.load(memory_order_acquire);
+        if (waited == nullptr) {
+            return {};
+        }
+        cycle.push_back({ current, waited });
+        Waiter* holder = waited->current_owner();
+        if (holder == nullptr) {
+            return {}; // Released meanwhile; the wait is making progress
+        }
+        if (holder == &self) {
+            return cycle;
+        }
+        current = holder;
+    }
+    return {}; // A cycle not through this thread; its members report it
+}
+
+LockMonitor::Waiter* LockMonitor::choose_victim(const vector<CycleEdge>& cycle) {
+    Waiter* victim = nullptr;
+    bool victim_abortable = false;
+    for (const CycleEdge& edge : cycle) {
+        bool abortable = policy.abort_victim && edge.waiter->abortable.load(memory_order_relaxed);
+        // Prefer a waiter that can give way, then the youngest thread
+        if (victim == nullptr || abortable > victim_abortable ||
+            (abortable == victim_abortable && edge.waiter->thread_number > victim->thread_number)) {
+            victim = edge.waiter;
+            victim_abortable = abortable;
+        }
+    }
+    return victim;
+}
+
+void LockMonitor::report(const vector<CycleEdge>& cycle, const Waiter& victim, bool aborted) {
+    deadlock_count.fetch_add(1, memory_order_relaxed);
+    Logger* target = logger.load(memory_order_acquire);
+    if (target == nullptr) {
+        return;
+    }
+    ostringstream message;
+    message << "Deadlock detected:";
+    for (size_t i = 0; i < cycle.size(); ++i) {
+        const CycleEdge& next = cycle[(i + 1) % cycle.size()];
+        message << (i == 0 ? " " : "; ") << "thread " << cycle[i].waiter->thread_number << " waits for "
+                << cycle[i].lock->name() << " held by thread " << next.waiter->thread_number;
+    }
+    message << "; victim thread " << victim.thread_number << (aborted ? " aborted" : " not abortable");
+    target->log<LogLevel::Error>(LogCategory::System, message.str());
+}
+
+bool MonitoredMutex::lock_slow(bool abortable) {
+    uint64_t wait_start = LockMonitor::profiling() ? now_ns() : 0;
+    LockMonitor::Waiter& self = LockMonitor::local_waiter();
+    const DeadlockPolicy& policy = LockMonitor::deadlock_policy();
+    self.abortable.store(abortable, memory_order_relaxed);
+    self.waiting_for.store(this, memory_order_release);
+    bool checked = false;
+    // A system clock deadline waits in pthread_mutex_timedlock, which thread
+    // sanitizers understand, unlike the steady clock's clocklock
+    while (!mtx.try_lock_until(chrono::system_clock::now() + policy.wait_timeout)) {
+        if (checked) {
+            continue; // The cycle this wait is part of is already handled
+        }
+        vector<LockMonitor::CycleEdge> cycle = LockMonitor::find_cycle(self);
+        if (cycle.empty()) {
+            continue;
+        }
+        checked = true;
+        // Every thread of the cycle finds it; only the victim reports it
+        if (LockMonitor::choose_victim(cycle) != &self) {
+            continue;
+        }
+        bool abort = abortable && policy.abort_victim;
+        LockMonitor::report(cycle, self, abort);
+        if (abort) {
+            self.waiting_for.store(nullptr, memory_order_release);
+            return false;
+        }
+    }
+    self.waiting_for.store(nullptr, memory_order_release);
+    acquired();
+    if (wait_start != 0 && acquired_ns != 0) {
+        stats.contended.fetch_add(1, memory_order_relaxed);
+        stats.wait.record(acquired_ns - wait_start);
+    }
+    return true;
+}
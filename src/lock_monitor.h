@@ -0,0 +1,187 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Logger;
+class MonitoredMutex;
+
+// How long-waiting lock acquisitions look for deadlocks
+struct DeadlockPolicy {
+    std::chrono::milliseconds wait_timeout{ 50 }; // Waits longer than this check the wait-for graph
+    bool abort_victim = false;                    // The cycle's victim gives up its lock_or_abort()
+};
+
+// Power-of-two histogram of nanosecond durations, safe to record into from
+// any thread
+class LockTimeHistogram {
+private:
+    std::array<std::atomic<uint64_t>, 64> buckets{}; // Bucket i holds [2^(i-1), 2^i)
+    std::atomic<uint64_t> total_ns{ 0 };
+
+public:
+    void record(uint64_t value_ns);
+
+    uint64_t count() const;
+    uint64_t total() const { return total_ns.load(std::memory_order_relaxed); }
+
+    // Upper bound of the bucket holding the percentile, within 2x
+    uint64_t percentile(double p) const;
+};
+
+// Contention profile of every lock sharing a name
+struct LockStats {
+    std::string name;
+    std::atomic<uint64_t> acquisitions{ 0 };
+    std::atomic<uint64_t> contended{ 0 }; // Acquisitions that had to wait
+    LockTimeHistogram wait;               // Contended acquisitions only
+    LockTimeHistogram hold;
+
+    explicit LockStats(const std::string& name) : name(name) {}
+};
+
+// LockMonitor class for deadlock detection across MonitoredMutex locks.
+// The wait-for graph is kept implicitly: every lock records its owning
+// thread and every blocked thread the lock it waits for. A thread that has
+// waited longer than the policy's timeout follows those edges; if they lead
+// back to itself the threads form a cycle, which is logged to errors.log
+// once by its victim: the youngest of its threads, preferring those
+// waiting in lock_or_abort(), which give the lock up when
+// DeadlockPolicy::abort_victim is set.
+// With profiling on, every lock also counts its acquisitions and the ones
+// that had to wait, and records wait and hold times, per lock name.
+class LockMonitor {
+public:
+    // A thread as seen by the wait-for graph
+    struct Waiter {
+        uint64_t thread_number;
+        std::atomic<MonitoredMutex*> waiting_for{ nullptr };
+        std::atomic<bool> abortable{ false }; // Waiting in lock_or_abort()
+
+        Waiter();
+        ~Waiter();
+    };
+
+    // One edge pair of a cycle: `waiter` waits for `lock`, which is owned by
+    // the next entry's waiter
+    struct CycleEdge {
+        Waiter* waiter;
+        MonitoredMutex* lock;
+    };
+
+private:
+    static std::atomic<Logger*> logger;
+    static std::atomic<uint64_t> deadlock_count;
+    static DeadlockPolicy policy;
+    static std::mutex graph_mtx; // Held while walking the graph and by exiting threads
+
+    static std::atomic<bool> profiling_enabled;
+
+public:
+    // Where cycles are reported; nullptr stops reporting
+    static void set_logger(Logger* logger);
+
+    // Set before the monitored locks are in use
+    static void set_policy(const DeadlockPolicy& policy);
+
+    static const DeadlockPolicy& deadlock_policy() { return policy; }
+
+    // Cycles detected since start
+    static uint64_t deadlocks() { return deadlock_count.load(std::memory_order_relaxed); }
+
+    // Contention profiling costs two clock reads per acquisition while on
+    static void set_profiling(bool enabled) { profiling_enabled.store(enabled, std::memory_order_relaxed); }
+
+    static bool profiling() { return profiling_enabled.load(std::memory_order_relaxed); }
+
+    // Profile shared by the locks named `name`; lives as long as the process
+    static LockStats& stats_for(const std::string& name);
+
+    // One line per lock name, most total wait first
+    static std::string contention_report();
+
+    static Waiter& local_waiter() {
+        thread_local Waiter waiter;
+        return waiter;
+    }
+
+    // Cycle of waiting threads through `self`, or an empty vector
+    static std::vector<CycleEdge> find_cycle(Waiter& self);
+
+    // The thread of the cycle that gives way (an abortable waiter if any),
+    // and reports it
+    static Waiter* choose_victim(const std::vector<CycleEdge>& cycle);
+
+    static void report(const std::vector<CycleEdge>& cycle, const Waiter& victim, bool aborted);
+};
+
+// MonitoredMutex class: a named mutex the LockMonitor can see. It meets
+// the standard Lockable requirements, so lock_guard, unique_lock and
+// condition_variable_any work with it. Uncontended acquisitions cost one
+// try_lock and an owner store.
+class MonitoredMutex {
+private:
+    std::timed_mutex mtx;
+    const char* lock_name;
+    std::atomic<LockMonitor::Waiter*> owner{ nullptr };
+    LockStats& stats;
+    uint64_t acquired_ns = 0; // When a profiled hold started; guarded by the lock
+
+    static uint64_t now_ns() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    void acquired() {
+        owner.store(&LockMonitor::local_waiter(), std::memory_order_release);
+        if (LockMonitor::profiling()) {
+            stats.acquisitions.fetch_add(1, std::memory_order_relaxed);
+            acquired_ns = now_ns();
+        }
+    }
+
+    // Wait for the lock, checking for deadlocks every policy timeout
+    bool lock_slow(bool abortable);
+
+public:
+    explicit MonitoredMutex(const char* name) : lock_name(name), stats(LockMonitor::stats_for(name)) {}
+
+    MonitoredMutex(const MonitoredMutex&) = delete;
+    MonitoredMutex& operator=(const MonitoredMutex&) = delete;
+
+    void lock() {
+        if (!try_lock()) {
+            lock_slow(false);
+        }
+    }
+
+    bool try_lock() {
+        if (!mtx.try_lock()) {
+            return false;
+        }
+        acquired();
+        return true;
+    }
+
+    void unlock() {
+        if (acquired_ns != 0) {
+            stats.hold.record(now_ns() - acquired_ns);
+            acquired_ns = 0;
+        }
+        owner.store(nullptr, std::memory_order_release);
+        mtx.unlock();
+    }
+
+    // Lock, unless this thread is picked as the victim of a deadlock cycle;
+    // false then, and the caller must abandon its work
+    bool lock_or_abort() { return try_lock() || lock_slow(true); }
+
+    const char* name() const { return lock_name; }
+
+    LockMonitor::Waiter* current_owner() const { return owner.load(std::memory_order_acquire); }
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+#include "log_format.h"
+
+// ThreadLogBuffer class for one thread's pending transaction records.
+// The owning thread is the only producer and the log writer the only
+// consumer, so claiming and publishing a slot needs no lock or RMW.
+class ThreadLogBuffer {
+public:
+    static constexpr size_t SLOTS = 256;
+
+    struct Slot {
+        uint64_t sequence = 0; // Global order assigned when the record is published
+        LogLine line;
+    };
+
+    // Set when the owning Logger is destroyed so the thread drops its handle
+    std::atomic<bool> closed{ false };
+
+private:
+    alignas(64) std::atomic<size_t> head{ 0 }; // Next slot the writer consumes
+    alignas(64) std::atomic<size_t> tail{ 0 }; // Next slot the owner fills
+    Slot slots[SLOTS];
+
+public:
+    bool full() const {
+        return tail.load(std::memory_order_relaxed) - head.load(std::memory_order_acquire) == SLOTS;
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_relaxed) == tail.load(std::memory_order_acquire);
+    }
+
+    // Producer: slot to fill next, waiting for the writer if the ring is full
+    Slot& claim() {
+        size_t t = tail.load(std::memory_order_relaxed);
+        while (t - head.load(std::memory_order_acquire) == SLOTS) {
+            std::this_thread::yield();
+        }
+        return slots[t % SLOTS];
+    }
+
+    // Producer: make the claimed slot visible to the writer
+    void publish() {
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Consumer: oldest published slot, or nullptr when empty
+    Slot* front() {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &slots[h % SLOTS];
+    }
+
+    // Consumer: release the slot returned by front()
+    void pop() {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+};
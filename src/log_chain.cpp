@@ -0,0 +1,260 @@
+#include "log_chain.h"
+
+#include <cstring>
+#include <sstream>
+#include <utility>
+
+#ifdef BANKING_HAVE_OPENSSL
+// The low-level SHA-256 calls are deprecated in OpenSSL 3 but are several
+// times faster than SHA256() and EVP for record-sized inputs, which fetch
+// the algorithm on every call
+#define OPENSSL_SUPPRESS_DEPRECATED
+#include <openssl/sha.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+// SHA-256 of prefix || first || second
+void sha256(unsigned char prefix, const void* first, size_t first_size, const void* second, size_t second_size,
+            unsigned char* digest) {
+#ifdef BANKING_HAVE_OPENSSL
+    SHA256_CTX context;
+    SHA256_Init(&context);
+    SHA256_Update(&context, &prefix, 1);
+    SHA256_Update(&context, first, first_size);
+    SHA256_Update(&context, second, second_size);
+    SHA256_Final(digest, &context);
+#else
+    (void)prefix;
+    (void)first;
+    (void)first_size;
+    (void)second;
+    (void)second_size;
+    memset(digest, 0, 32);
+#endif
+}
+
+constexpr char HEX_DIGITS[] = "0123456789abcdef";
+
+void write_hex(const unsigned char* bytes, size_t size, char* out) {
+    for (size_t i = 0; i < size; ++i) {
+        out[2 * i] = HEX_DIGITS[bytes[i] >> 4];
+        out[2 * i + 1] = HEX_DIGITS[bytes[i] & 0x0f];
+    }
+}
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+}
+
+LogChain::LogChain(SegmentedLog& log, const LogIntegrityPolicy& policy)
+    : log(log), policy(policy), enabled(policy.hash_chain && supported()) {
+    if (!enabled) {
+        return;
+    }
+    string path = checkpoint_path_for(log.path());
+    vector<LogCheckpoint> existing = load_checkpoints(path);
+    resume(existing);
+    checkpoints.open(path, existing.empty() ? ios::trunc : ios::app);
+    if (existing.empty()) {
+        checkpoints << "# index first_record records segment offset bytes chain_start chain_end merkle_root\n";
+        checkpoints.flush();
+    }
+    leaves.reserve(policy.checkpoint_records);
+}
+
+void LogChain::resume(const vector<LogCheckpoint>& existing) {
+    if (existing.empty()) {
+        // A new chain starts with the next record; earlier records stay unsealed
+        return;
+    }
+    const LogCheckpoint& last = existing.back();
+    chain = last.chain_end;
+    next_index = last.index + 1;
+    next_record = last.first_record + last.records;
+
+    // Adopt records sealed after the last checkpoint (the previous run did
+    // not close its block) as long as they still link up
+    uint64_t start = last.segment_id == log.active_segment_id() ? last.offset + last.bytes : 0;
+    LogReader reader(vector<string>{ log.path() });
+    string line;
+    while (reader.next(line)) {
+        if (reader.record_offset() < start) {
+            continue;
+        }
+        string_view record, link;
+        if (!split_link(line, record, link) || !link_matches(link, chain)) {
+            break;
+        }
+        if (block.records == 0) {
+            block = LogCheckpoint{};
+            block.index = next_index;
+            block.first_record = next_record;
+            block.segment_id = log.active_segment_id();
+            block.offset = reader.record_offset();
+            block.chain_start = chain;
+        }
+        add_record(record, line.size() + 1);
+    }
+}
+
+void LogChain::add_record(string_view record, size_t line_bytes) {
+    chain = chain_hash(chain, record);
+    leaves.push_back(chain);
+    ++block.records;
+    block.bytes += line_bytes;
+}
+
+void LogChain::seal(LogLine& line) {
+    if (!enabled) {
+        return;
+    }
+    line.truncate(LogLine::CAPACITY - LINK_SIZE);
+    if (block.records == 0) {
+        block = LogCheckpoint{};
+        block.index = next_index;
+        block.first_record = next_record;
+        block.segment_id = log.active_segment_id();
+        block.offset = log.active_size();
+        block.chain_start = chain;
+    }
+
+    char link[2 * LINK_HASH_BYTES];
+    write_hex(chain.data(), LINK_HASH_BYTES, link);
+    add_record(line.view(), line.size() + LINK_SIZE + 1);
+    line.append(LINK_TAG);
+    line.append(string_view(link, sizeof(link)));
+}
+
+void LogChain::after_append() {
+    if (block.records != 0 && (block.records >= policy.checkpoint_records || log.active_segment_id() != block.segment_id)) {
+        checkpoint();
+    }
+}
+
+void LogChain::checkpoint() {
+    if (!enabled || block.records == 0) {
+        return;
+    }
+    block.chain_end = chain;
+    block.merkle_root = merkle_root(move(leaves));
+    leaves.clear();
+    leaves.reserve(policy.checkpoint_records);
+
+    checkpoints << block.index << ' ' << block.first_record << ' ' << block.records << ' ' << block.segment_id << ' '
+                << block.offset << ' ' << block.bytes << ' ' << to_hex(block.chain_start) << ' '
+                << to_hex(block.chain_end) << ' ' << to_hex(block.merkle_root) << '\n';
+    checkpoints.flush();
+
+    next_index = block.index + 1;
+    next_record = block.first_record + block.records;
+    block.records = 0;
+}
+
+string LogChain::checkpoint_path_for(const string& active_path) {
+    return active_path + ".chain";
+}
+
+vector<LogCheckpoint> LogChain::load_checkpoints(const string& path) {
+    vector<LogCheckpoint> result;
+    ifstream in(path);
+    string line;
+    while (getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        istringstream fields(line);
+        LogCheckpoint checkpoint;
+        string start, end, root;
+        if (fields >> checkpoint.index >> checkpoint.first_record >> checkpoint.records >> checkpoint.segment_id >>
+                checkpoint.offset >> checkpoint.bytes >> start >> end >> root &&
+            from_hex(start, checkpoint.chain_start) && from_hex(end, checkpoint.chain_end) &&
+            from_hex(root, checkpoint.merkle_root)) {
+            result.push_back(checkpoint);
+        }
+    }
+    return result;
+}
+
+LogHash LogChain::chain_hash(const LogHash& chain, string_view record) {
+    // Chain values and Merkle nodes hash under distinct prefixes, so one can
+    // never pose as the other
+    LogHash digest;
+    sha256(0x00, chain.data(), chain.size(), record.data(), record.size(), digest.data());
+    return digest;
+}
+
+LogHash LogChain::merkle_root(vector<LogHash> nodes) {
+    if (nodes.empty()) {
+        return LogHash{};
+    }
+    while (nodes.size() > 1) {
+        size_t parents = 0;
+        for (size_t i = 0; i < nodes.size(); i += 2) {
+            if (i + 1 == nodes.size()) {
+                // An odd node is promoted to the next level unchanged
+                nodes[parents++] = nodes[i];
+                break;
+            }
+            LogHash parent;
+            sha256(0x01, nodes[i].data(), nodes[i].size(), nodes[i + 1].data(), nodes[i + 1].size(), parent.data());
+            nodes[parents++] = parent;
+        }
+        nodes.resize(parents);
+    }
+    return nodes[0];
+}
+
+bool LogChain::split_link(string_view line, string_view& record, string_view& link) {
+    if (line.size() < LINK_SIZE || line.substr(line.size() - LINK_SIZE, LINK_TAG.size()) != LINK_TAG) {
+        return false;
+    }
+    record = line.substr(0, line.size() - LINK_SIZE);
+    link = line.substr(line.size() - 2 * LINK_HASH_BYTES);
+    return true;
+}
+
+bool LogChain::link_matches(string_view link, const LogHash& chain) {
+    char expected[2 * LINK_HASH_BYTES];
+    write_hex(chain.data(), LINK_HASH_BYTES, expected);
+    return link == string_view(expected, sizeof(expected));
+}
+
+string LogChain::to_hex(const LogHash& hash) {
+    string hex(2 * hash.size(), '0');
+    write_hex(hash.data(), hash.size(), hex.data());
+    return hex;
+}
+
+bool LogChain::from_hex(string_view hex, LogHash& hash) {
+    if (hex.size() != 2 * hash.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < hash.size(); ++i) {
+        int high = hex_value(hex[2 * i]);
+        int low = hex_value(hex[2 * i + 1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        hash[i] = static_cast<unsigned char>(high << 4 | low);
+    }
+    return true;
+}
+
+bool LogChain::supported() {
+#ifdef BANKING_HAVE_OPENSSL
+    return true;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "log_format.h"
+#include "log_segments.h"
+
+// How the transaction log is sealed for audit
+struct LogIntegrityPolicy {
+    bool hash_chain = true;          // Needs OpenSSL; ignored in builds without it
+    size_t checkpoint_records = 4096; // Records per Merkle checkpoint at most
+};
+
+using LogHash = std::array<unsigned char, 32>;
+
+// A Merkle checkpoint over a block of consecutive records. A block never
+// spans segments, so it can be verified from its own segment alone.
+struct LogCheckpoint {
+    uint64_t index = 0;
+    uint64_t first_record = 0; // Records sealed before this block
+    uint64_t records = 0;
+    uint64_t segment_id = 0;   // SegmentedLog id of the segment holding the block
+    uint64_t offset = 0;       // Uncompressed offset of the first record
+    uint64_t bytes = 0;
+    LogHash chain_start{};     // Chain value before the first record
+    LogHash chain_end{};       // Chain value after the last record
+    LogHash merkle_root{};     // Root over the records' chain values
+};
+
+// LogChain class for sealing transaction records into a hash chain.
+// Every record gets " prev=<hex>" appended: the first 128 bits of the chain
+// value before it, where chain = SHA-256(0x00 || chain || record). Each
+// block of up to checkpoint_records records is closed with a Merkle root over
+// its records' chain values (nodes are SHA-256(0x01 || left || right)),
+// appended to <log>.chain; blocks are also closed on flush and when the
+// segment rotates.
+// Editing, dropping or reordering a record breaks its block's chain and
+// root. Used only on the log's writer thread, around SegmentedLog::append.
+class LogChain {
+public:
+    static constexpr std::string_view LINK_TAG = " prev=";
+    static constexpr size_t LINK_HASH_BYTES = 16;
+    static constexpr size_t LINK_SIZE = LINK_TAG.size() + 2 * LINK_HASH_BYTES;
+
+private:
+    SegmentedLog& log;
+    LogIntegrityPolicy policy;
+    bool enabled = false;
+    std::ofstream checkpoints;
+
+    LogHash chain{};
+    uint64_t next_index = 0;
+    uint64_t next_record = 0;
+
+    // Block being sealed and its Merkle leaves; block.records == 0 when none is open
+    LogCheckpoint block;
+    std::vector<LogHash> leaves;
+
+    void add_record(std::string_view record, size_t line_bytes);
+    void resume(const std::vector<LogCheckpoint>& existing);
+
+public:
+    // Continues the chain recorded in <log>.chain, adopting records a previous
+    // run wrote after its last checkpoint
+    LogChain(SegmentedLog& log, const LogIntegrityPolicy& policy = {});
+
+    bool is_enabled() const { return enabled; }
+
+    // Append the chain link to a record about to be appended to the log
+    void seal(LogLine& line);
+
+    // Call after each append and rotation: closes the block once it is full
+    // or its segment has been rotated out
+    void after_append();
+
+    // Close the open block, if any, and write its checkpoint
+    void checkpoint();
+
+    static std::string checkpoint_path_for(const std::string& active_path);
+    static std::vector<LogCheckpoint> load_checkpoints(const std::string& path);
+
+    static LogHash chain_hash(const LogHash& chain, std::string_view record);
+    static LogHash merkle_root(std::vector<LogHash> leaves);
+
+    // Split a sealed record into its content and link hex; false if unsealed
+    static bool split_link(std::string_view line, std::string_view& record, std::string_view& link);
+
+    // Whether `link` is the hex of the first LINK_HASH_BYTES of `chain`
+    static bool link_matches(std::string_view link, const LogHash& chain);
+
+    static std::string to_hex(const LogHash& hash);
+    static bool from_hex(std::string_view hex, LogHash& hash);
+
+    // True when this build can hash (OpenSSL was found)
+    static bool supported();
+};
@@ -0,0 +1,44 @@
+#include "log_format.h"
+
+#include <chrono>
+
+using namespace std;
+
+void TimestampCache::refresh(time_t second) {
+    char text[26];
+#ifdef _WIN32
+    ctime_s(text, sizeof(text), &second);
+#else
+    ctime_r(&second, text);
+#endif
+    memcpy(prefix, text, 19);
+    prefix[19] = '\0';
+    memcpy(suffix, text + 19, 5);
+    suffix[5] = '\0';
+    cached_second = second;
+}
+
+void TimestampCache::format(LogLine& line) {
+    auto now = chrono::system_clock::now();
+    auto micros = chrono::duration_cast<chrono::microseconds>(now.time_since_epoch()).count();
+    time_t second = static_cast<time_t>(micros / 1000000);
+    if (second != cached_second) {
+        refresh(second);
+    }
+
+    line.append(string_view(prefix, 19));
+    char fraction[7];
+    int64_t sub = micros % 1000000;
+    for (int i = 6; i >= 1; --i) {
+        fraction[i] = static_cast<char>('0' + sub % 10);
+        sub /= 10;
+    }
+    fraction[0] = '.';
+    line.append(string_view(fraction, 7));
+    line.append(string_view(suffix, 5));
+}
+
+TimestampCache& TimestampCache::local() {
+    thread_local TimestampCache cache;
+    return cache;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// LogLine class for building a log record without heap allocations.
+// Text is written straight into a fixed buffer; records longer than
+// CAPACITY are truncated rather than reallocated.
+class LogLine {
+public:
+    static constexpr size_t CAPACITY = 512;
+
+private:
+    char buffer[CAPACITY];
+    size_t length = 0;
+
+public:
+    void clear() { length = 0; }
+    void truncate(size_t size) { length = size < length ? size : length; }
+    const char* data() const { return buffer; }
+    size_t size() const { return length; }
+    std::string_view view() const { return std::string_view(buffer, length); }
+
+    void append(std::string_view text) {
+        size_t n = text.size() < CAPACITY - length ? text.size() : CAPACITY - length;
+        std::memcpy(buffer + length, text.data(), n);
+        length += n;
+    }
+
+    void append(const char* text) { append(std::string_view(text)); }
+    void append(const std::string& text) { append(std::string_view(text)); }
+
+    void append(char c) {
+        if (length < CAPACITY) {
+            buffer[length++] = c;
+        }
+    }
+
+    // Integers use to_chars; floats keep the fixed six-decimal layout of
+    // std::to_string so existing log parsers see the same records
+    template <typename T>
+    std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, char> && !std::is_same_v<T, bool>> append(T value) {
+        auto result = std::to_chars(buffer + length, buffer + CAPACITY, value);
+        if (result.ec == std::errc()) {
+            length = static_cast<size_t>(result.ptr - buffer);
+        }
+    }
+
+    template <typename T>
+    std::enable_if_t<std::is_floating_point_v<T>> append(T value) {
+        auto result = std::to_chars(buffer + length, buffer + CAPACITY, value, std::chars_format::fixed, 6);
+        if (result.ec == std::errc()) {
+            length = static_cast<size_t>(result.ptr - buffer);
+        }
+    }
+
+    // Write "[<timestamp>] " using the calling thread's timestamp cache
+    void append_timestamp();
+
+    template <typename... Parts>
+    void append_all(const Parts&... parts) {
+        (append(parts), ...);
+    }
+};
+
+// TimestampCache class for ctime-style timestamps with microseconds.
+// The calendar text is only re-rendered when the second changes; in between,
+// formatting is a copy plus the sub-second offset.
+class TimestampCache {
+private:
+    time_t cached_second = -1;
+    char prefix[20]; // "Www Mmm dd hh:mm:ss"
+    char suffix[6];  // " yyyy"
+
+    void refresh(time_t second);
+
+public:
+    // Write "Www Mmm dd hh:mm:ss.uuuuuu yyyy" into `line`
+    void format(LogLine& line);
+
+    // Per-thread instance so refreshes never contend
+    static TimestampCache& local();
+};
+
+inline void LogLine::append_timestamp() {
+    append('[');
+    TimestampCache::local().format(*this);
+    append("] ");
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Severity of a log record. Audit and above are never filtered or sampled:
+// they are the records an audit of the books relies on.
+enum class LogLevel : uint8_t {
+    Trace,
+    Debug,
+    Info,    // High-volume success events (deposits, withdrawals, transfers)
+    Audit,   // Account lifecycle and balance overrides
+    Warning,
+    Error,
+};
+
+// Subsystem a record comes from; filtering and sampling are per category
+enum class LogCategory : uint8_t {
+    Account,
+    Transaction,
+    Process,
+    Memory,
+    IPC,
+    System,
+};
+
+constexpr size_t LOG_CATEGORY_COUNT = 6;
+
+// Lowest level compiled into the binary (0 = Trace ... 5 = Error), set by the
+// BANKING_LOG_LEVEL CMake option. Calls below it compile to nothing, except
+// that Audit and above are always kept.
+#ifndef BANKING_LOG_LEVEL
+#define BANKING_LOG_LEVEL 2
+#endif
+
+constexpr LogLevel COMPILED_LOG_LEVEL = static_cast<LogLevel>(BANKING_LOG_LEVEL);
+
+constexpr bool log_level_compiled_in(LogLevel level) {
+    return level >= LogLevel::Audit || level >= COMPILED_LOG_LEVEL;
+}
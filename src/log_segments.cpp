@@ -0,0 +1,534 @@
+#include "log_segments.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <sstream>
+#include <sys/stat.h>
+
+#ifdef BANKING_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+int64_t unix_now() {
+    return static_cast<int64_t>(time(nullptr));
+}
+
+bool file_exists(const string& path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0;
+}
+
+uint64_t file_size(const string& path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 ? static_cast<uint64_t>(info.st_size) : 0;
+}
+
+bool ends_with(const string& text, const string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+}
+
+bool LogSegment::compressed() const {
+    return ends_with(path, ".gz");
+}
+
+SegmentedLog::SegmentedLog(const string& path, const LogRotationPolicy& policy)
+    : active_path(path), index_path(index_path_for(path)), policy(policy) {
+    segments = load_index(index_path);
+    for (const auto& segment : segments) {
+        next_segment_id = max(next_segment_id, segment.id + 1);
+    }
+    open_active();
+
+    if (policy.compress && compression_supported()) {
+        // Segments closed by a previous run that never got compressed
+        for (const auto& segment : segments) {
+            if (!segment.compressed()) {
+                compress_queue.push_back(segment.id);
+            }
+        }
+        compressor = thread(&SegmentedLog::run_compressor, this);
+    }
+}
+
+SegmentedLog::~SegmentedLog() {
+    active.close();
+    {
+        lock_guard<mutex> lock(index_mtx);
+        stopping = true;
+    }
+    compress_cv.notify_all();
+    if (compressor.joinable()) {
+        compressor.join();
+    }
+}
+
+void SegmentedLog::open_active() {
+    active.open(active_path, ios::app | ios::binary);
+    active_bytes = file_size(active_path);
+    active_records = 0;
+    active_opened_at = unix_now();
+}
+
+void SegmentedLog::append(const char* data, size_t size) {
+    active.write(data, static_cast<streamsize>(size));
+    active.put('\n');
+    active_bytes += size + 1;
+    ++active_records;
+    if (policy.max_segment_bytes != 0 && active_bytes >= policy.max_segment_bytes) {
+        rotate();
+    }
+}
+
+void SegmentedLog::flush() {
+    active.flush();
+}
+
+bool SegmentedLog::rotate_if_due() {
+    bool too_big = policy.max_segment_bytes != 0 && active_bytes >= policy.max_segment_bytes;
+    bool too_old = policy.max_segment_age.count() != 0 && active_bytes != 0 && unix_now() - active_opened_at >= policy.max_segment_age.count();
+    if (too_big || too_old) {
+        rotate();
+        return true;
+    }
+    return false;
+}
+
+void SegmentedLog::rotate() {
+    if (active_bytes == 0) {
+        return;
+    }
+    active.close();
+
+    LogSegment segment;
+    segment.id = next_segment_id++;
+    segment.path = segment_path(active_path, segment.id);
+    segment.records = active_records;
+    segment.bytes = active_bytes;
+    segment.opened_at = active_opened_at;
+    segment.closed_at = unix_now();
+    if (rename(active_path.c_str(), segment.path.c_str()) != 0) {
+        // Keep appending to the same file rather than losing records
+        --next_segment_id;
+        active.open(active_path, ios::app | ios::binary);
+        return;
+    }
+    open_active();
+
+    if (rotation_listener) {
+        rotation_listener(segment);
+    }
+    {
+        lock_guard<mutex> lock(index_mtx);
+        segments.push_back(segment);
+        save_index_locked();
+        if (compressor.joinable()) {
+            compress_queue.push_back(segment.id);
+        }
+    }
+    compress_cv.notify_one();
+}
+
+vector<LogSegment> SegmentedLog::closed_segments() const {
+    lock_guard<mutex> lock(index_mtx);
+    return segments;
+}
+
+void SegmentedLog::save_index_locked() {
+    string tmp_path = index_path + ".tmp";
+    {
+        ofstream out(tmp_path, ios::trunc);
+        out << "# id records bytes opened_at closed_at path\n";
+        for (const auto& segment : segments) {
+            out << segment.id << ' ' << segment.records << ' ' << segment.bytes << ' '
+                << segment.opened_at << ' ' << segment.closed_at << ' ' << segment.path << '\n';
+        }
+    }
+    rename(tmp_path.c_str(), index_path.c_str());
+}
+
+void SegmentedLog::run_compressor() {
+    unique_lock<mutex> lock(index_mtx);
+    for (;;) {
+        compress_cv.wait(lock, [this] { return stopping || !compress_queue.empty(); });
+        if (compress_queue.empty()) {
+            return;
+        }
+        uint64_t id = compress_queue.front();
+        compress_queue.pop_front();
+
+        string raw_path;
+        for (const auto& segment : segments) {
+            if (segment.id == id) {
+                raw_path = segment.path;
+            }
+        }
+        if (raw_path.empty() || ends_with(raw_path, ".gz")) {
+            continue;
+        }
+
+        lock.unlock();
+        string compressed_path = raw_path + ".gz";
+        bool ok = compress_segment(raw_path, compressed_path);
+        lock.lock();
+
+        if (ok) {
+            for (auto& segment : segments) {
+                if (segment.id == id) {
+                    segment.path = compressed_path;
+                }
+            }
+            save_index_locked();
+            // Readers resolve a missing raw file to its .gz, so removing
+            // it after the index update is safe
+            remove(raw_path.c_str());
+        }
+    }
+}
+
+bool SegmentedLog::compress_segment(const string& raw_path, const string& compressed_path) {
+#ifdef BANKING_HAVE_ZLIB
+    ifstream in(raw_path, ios::binary);
+    if (!in) {
+        return false;
+    }
+    string tmp_path = compressed_path + ".tmp";
+    gzFile out = gzopen(tmp_path.c_str(), "wb6");
+    if (out == nullptr) {
+        return false;
+    }
+    // A full flush before each chunk resets the deflate state, so reading
+    // can start at that compressed offset without decoding what precedes it
+    vector<uint64_t> seek_points;
+    vector<char> chunk(SEEK_POINT_INTERVAL);
+    uint64_t raw_offset = 0;
+    bool ok = true;
+    while (in) {
+        in.read(chunk.data(), static_cast<streamsize>(chunk.size()));
+        streamsize n = in.gcount();
+        if (n <= 0) {
+            break;
+        }
+        if (gzflush(out, Z_FULL_FLUSH) != Z_OK) {
+            ok = false;
+            break;
+        }
+        seek_points.push_back(raw_offset);
+        seek_points.push_back(static_cast<uint64_t>(gzoffset(out)));
+        if (gzwrite(out, chunk.data(), static_cast<unsigned>(n)) != static_cast<int>(n)) {
+            ok = false;
+            break;
+        }
+        raw_offset += static_cast<uint64_t>(n);
+    }
+    ok = gzclose(out) == Z_OK && ok;
+    if (ok) {
+        ofstream table(compressed_path + ".seek", ios::binary | ios::trunc);
+        table.write(reinterpret_cast<const char*>(seek_points.data()), static_cast<streamsize>(seek_points.size() * sizeof(uint64_t)));
+        ok = static_cast<bool>(table);
+    }
+    if (!ok || rename(tmp_path.c_str(), compressed_path.c_str()) != 0) {
+        remove(tmp_path.c_str());
+        remove((compressed_path + ".seek").c_str());
+        return false;
+    }
+    return true;
+#else
+    (void)raw_path;
+    (void)compressed_path;
+    return false;
+#endif
+}
+
+string SegmentedLog::segment_path(const string& active_path, uint64_t id) {
+    char number[32];
+    snprintf(number, sizeof(number), "%06llu", static_cast<unsigned long long>(id));
+    string stem = active_path;
+    string extension;
+    size_t dot = active_path.rfind('.');
+    size_t slash = active_path.rfind('/');
+    if (dot != string::npos && (slash == string::npos || dot > slash)) {
+        stem = active_path.substr(0, dot);
+        extension = active_path.substr(dot);
+    }
+    return stem + "." + number + extension;
+}
+
+string SegmentedLog::index_path_for(const string& active_path) {
+    return active_path + ".index";
+}
+
+vector<LogSegment> SegmentedLog::load_index(const string& index_path) {
+    vector<LogSegment> result;
+    ifstream in(index_path);
+    string line;
+    while (getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        istringstream fields(line);
+        LogSegment segment;
+        if (fields >> segment.id >> segment.records >> segment.bytes >> segment.opened_at >> segment.closed_at >> segment.path) {
+            result.push_back(segment);
+        }
+    }
+    return result;
+}
+
+bool SegmentedLog::compression_supported() {
+#ifdef BANKING_HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+// One open segment: plain files through ifstream, compressed ones through zlib
+struct LogReader::Source {
+    ifstream plain;
+#ifdef BANKING_HAVE_ZLIB
+    gzFile compressed = nullptr;
+#endif
+    vector<char> buffer = vector<char>(1 << 16);
+    uint64_t position = 0; // Uncompressed bytes consumed so far
+
+    ~Source() {
+#ifdef BANKING_HAVE_ZLIB
+        if (compressed != nullptr) {
+            gzclose(compressed);
+        }
+#endif
+    }
+
+    bool next(string& line) {
+#ifdef BANKING_HAVE_ZLIB
+        if (compressed != nullptr) {
+            line.clear();
+            // Records longer than the buffer arrive in several pieces
+            while (gzgets(compressed, buffer.data(), static_cast<int>(buffer.size())) != nullptr) {
+                line += buffer.data();
+                if (!line.empty() && line.back() == '\n') {
+                    position += line.size();
+                    line.pop_back();
+                    return true;
+                }
+            }
+            position += line.size();
+            return !line.empty();
+        }
+#endif
+        if (!getline(plain, line)) {
+            return false;
+        }
+        position += line.size() + (plain.eof() ? 0 : 1);
+        return true;
+    }
+};
+
+LogReader::LogReader(const string& active_path) {
+    for (const auto& segment : SegmentedLog::load_index(SegmentedLog::index_path_for(active_path))) {
+        paths.push_back(segment.path);
+    }
+    paths.push_back(active_path);
+}
+
+LogReader::LogReader(vector<string> files) : paths(move(files)) {}
+
+LogReader::~LogReader() = default;
+
+bool LogReader::open_next() {
+    current.reset();
+    while (next_path < paths.size()) {
+        string path = paths[next_path++];
+        // The compressor may have replaced the raw segment since the index was read
+        if (!file_exists(path) && file_exists(path + ".gz")) {
+            path += ".gz";
+        }
+        auto source = make_unique<Source>();
+        if (ends_with(path, ".gz")) {
+#ifdef BANKING_HAVE_ZLIB
+            source->compressed = gzopen(path.c_str(), "rb");
+            if (source->compressed == nullptr) {
+                continue;
+            }
+#else
+            continue;
+#endif
+        }
+        else {
+            source->plain.open(path, ios::binary);
+            if (!source->plain) {
+                continue;
+            }
+        }
+        current = move(source);
+        current_path = path;
+        return true;
+    }
+    return false;
+}
+
+bool LogReader::next(string& line) {
+    for (;;) {
+        if (!current && !open_next()) {
+            return false;
+        }
+        uint64_t offset = current->position;
+        if (current->next(line)) {
+            current_offset = offset;
+            return true;
+        }
+        current.reset();
+    }
+}
+
+#ifdef BANKING_HAVE_ZLIB
+// Random access into a compressed segment through its seek table
+struct SegmentRecordReader::Compressed {
+    FILE* file = nullptr;
+    vector<pair<uint64_t, uint64_t>> points; // (uncompressed, compressed) offsets
+    z_stream stream{};
+    bool stream_ready = false;
+    bool at_end = true;
+    vector<unsigned char> input = vector<unsigned char>(4096);
+    string output;           // Decoded bytes not yet consumed
+    uint64_t output_start = 0; // Uncompressed offset of output[0]
+
+    ~Compressed() {
+        if (stream_ready) {
+            inflateEnd(&stream);
+        }
+        if (file != nullptr) {
+            fclose(file);
+        }
+    }
+
+    bool restart(const pair<uint64_t, uint64_t>& point) {
+        if (!stream_ready) {
+            if (inflateInit2(&stream, -15) != Z_OK) {
+                return false;
+            }
+            stream_ready = true;
+        }
+        else {
+            inflateReset(&stream);
+        }
+        stream.avail_in = 0;
+        output.clear();
+        output_start = point.first;
+        at_end = fseek(file, static_cast<long>(point.second), SEEK_SET) != 0;
+        return !at_end;
+    }
+
+    // Decode the next piece of the stream into `output`; false at the end
+    bool decode_more() {
+        if (at_end) {
+            return false;
+        }
+        if (stream.avail_in == 0) {
+            size_t n = fread(input.data(), 1, input.size(), file);
+            if (n == 0) {
+                at_end = true;
+                return false;
+            }
+            stream.next_in = input.data();
+            stream.avail_in = static_cast<uInt>(n);
+        }
+        char decoded[SEEK_POINT_INTERVAL];
+        stream.next_out = reinterpret_cast<Bytef*>(decoded);
+        stream.avail_out = sizeof(decoded);
+        int status = inflate(&stream, Z_NO_FLUSH);
+        output.append(decoded, sizeof(decoded) - stream.avail_out);
+        if (status == Z_STREAM_END || (status != Z_OK && status != Z_BUF_ERROR)) {
+            at_end = true;
+        }
+        return true;
+    }
+
+    bool read_at(uint64_t offset, string& line) {
+        auto it = upper_bound(points.begin(), points.end(), make_pair(offset, UINT64_MAX));
+        if (it == points.begin()) {
+            return false;
+        }
+        const auto& point = *(it - 1);
+        // Keep decoding forward when the record is in or just past the
+        // current block; otherwise jump to the nearest seek point
+        bool reachable = stream_ready && offset >= output_start && point.first <= output_start + output.size();
+        if (!reachable && !restart(point)) {
+            return false;
+        }
+        while (output_start + output.size() <= offset) {
+            output_start += output.size();
+            output.clear();
+            if (!decode_more()) {
+                return false;
+            }
+        }
+        output.erase(0, static_cast<size_t>(offset - output_start));
+        output_start = offset;
+
+        size_t newline;
+        while ((newline = output.find('\n')) == string::npos) {
+            if (!decode_more()) {
+                break;
+            }
+        }
+        line.assign(output, 0, newline == string::npos ? output.size() : newline);
+        return newline != string::npos;
+    }
+};
+#else
+struct SegmentRecordReader::Compressed {
+    bool read_at(uint64_t, string&) { return false; }
+};
+#endif
+
+SegmentRecordReader::SegmentRecordReader(const string& raw_path) {
+    plain.open(raw_path, ios::binary);
+    if (plain) {
+        return;
+    }
+#ifdef BANKING_HAVE_ZLIB
+    // The segment has been compressed: load its seek table
+    string compressed_path = raw_path + ".gz";
+    ifstream table(compressed_path + ".seek", ios::binary);
+    FILE* file = fopen(compressed_path.c_str(), "rb");
+    if (!table || file == nullptr) {
+        if (file != nullptr) {
+            fclose(file);
+        }
+        return;
+    }
+    compressed = make_unique<Compressed>();
+    compressed->file = file;
+    uint64_t pair_values[2];
+    while (table.read(reinterpret_cast<char*>(pair_values), sizeof(pair_values))) {
+        compressed->points.emplace_back(pair_values[0], pair_values[1]);
+    }
+#endif
+}
+
+SegmentRecordReader::~SegmentRecordReader() = default;
+
+bool SegmentRecordReader::is_open() const {
+    return plain.is_open() || compressed != nullptr;
+}
+
+bool SegmentRecordReader::read_at(uint64_t offset, string& line) {
+    if (compressed) {
+        return compressed->read_at(offset, line);
+    }
+    if (!plain.is_open()) {
+        return false;
+    }
+    plain.clear();
+    plain.seekg(static_cast<streamoff>(offset));
+    // Without its newline the record is still being written
+    return getline(plain, line) && !plain.eof();
+}
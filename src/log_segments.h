@@ -0,0 +1,171 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// When a log file is closed as a segment and a new one started
+struct LogRotationPolicy {
+    uint64_t max_segment_bytes = 64ull << 20; // 0 disables size-based rotation
+    std::chrono::seconds max_segment_age{ 0 }; // 0 disables time-based rotation
+    bool compress = true;                      // gzip closed segments in the background
+};
+
+// A closed segment as recorded in the segment index
+struct LogSegment {
+    uint64_t id = 0;
+    std::string path;      // Current file; ends in ".gz" once compressed
+    uint64_t records = 0;
+    uint64_t bytes = 0;    // Uncompressed size
+    int64_t opened_at = 0; // Unix seconds
+    int64_t closed_at = 0;
+
+    bool compressed() const;
+};
+
+// SegmentedLog class for an append-only log split into rotated segments.
+// The active file keeps its configured name (e.g. transactions.log); closed
+// segments are renamed to <stem>.<id>.log, listed in <name>.index, and
+// compressed on a background thread so rotation never blocks on zlib.
+// append() and rotate() must be called from one thread at a time.
+class SegmentedLog {
+private:
+    std::string active_path;
+    std::string index_path;
+    LogRotationPolicy policy;
+
+    std::ofstream active;
+    uint64_t active_bytes = 0;
+    uint64_t active_records = 0;
+    int64_t active_opened_at = 0;
+    uint64_t next_segment_id = 1;
+
+    std::vector<LogSegment> segments;
+    mutable std::mutex index_mtx;
+
+    std::function<void(const LogSegment&)> rotation_listener;
+
+    std::thread compressor;
+    std::deque<uint64_t> compress_queue;
+    std::condition_variable compress_cv;
+    bool stopping = false;
+
+    void open_active();
+    void save_index_locked();
+    void run_compressor();
+    bool compress_segment(const std::string& raw_path, const std::string& compressed_path);
+
+public:
+    SegmentedLog(const std::string& path, const LogRotationPolicy& policy = {});
+
+    ~SegmentedLog();
+
+    // Append one record followed by a newline; rotates when the size limit is hit
+    void append(const char* data, size_t size);
+
+    // Offset the next record will have within the active segment
+    uint64_t active_size() const { return active_bytes; }
+
+    // Id the active segment will get when it is closed
+    uint64_t active_segment_id() const { return next_segment_id; }
+
+    // Called on the appending thread each time a segment is closed, before
+    // it is queued for compression
+    void set_rotation_listener(std::function<void(const LogSegment&)> listener) { rotation_listener = std::move(listener); }
+
+    void flush();
+
+    // Rotate if the active segment is over its size or age limit
+    bool rotate_if_due();
+
+    // Unix time at which rotate_if_due() will close the active segment for
+    // its age; INT64_MAX while that cannot happen
+    int64_t rotation_due_at() const {
+        return policy.max_segment_age.count() != 0 && active_bytes != 0 ? active_opened_at + policy.max_segment_age.count() : INT64_MAX;
+    }
+
+    // Close the active segment (if non-empty) and start a new one
+    void rotate();
+
+    const std::string& path() const { return active_path; }
+
+    std::vector<LogSegment> closed_segments() const;
+
+    static std::string segment_path(const std::string& active_path, uint64_t id);
+    static std::string index_path_for(const std::string& active_path);
+    static std::vector<LogSegment> load_index(const std::string& index_path);
+
+    // True when this build can read and write compressed segments
+    static bool compression_supported();
+};
+
+// Compressed segments get a full-flush seek point every this many
+// uncompressed bytes, listed in <segment>.gz.seek
+constexpr size_t SEEK_POINT_INTERVAL = 16 * 1024;
+
+// SegmentRecordReader class for reading records at known offsets of one
+// closed segment, plain or compressed. A compressed read decodes at most one
+// seek interval before the record, or continues forward from the last read.
+class SegmentRecordReader {
+private:
+    struct Compressed;
+
+    std::ifstream plain;
+    std::unique_ptr<Compressed> compressed;
+
+public:
+    // Opens `raw_path`, or its ".gz" once the segment has been compressed
+    explicit SegmentRecordReader(const std::string& raw_path);
+
+    ~SegmentRecordReader();
+
+    bool is_open() const;
+
+    // Read the record starting at the uncompressed `offset`; false unless
+    // a whole record, newline included, is there
+    bool read_at(uint64_t offset, std::string& line);
+};
+
+// LogReader class for iterating records across all segments of a log, oldest
+// first, decompressing closed segments transparently and ending with the
+// active file
+class LogReader {
+private:
+    struct Source;
+
+    std::vector<std::string> paths;
+    size_t next_path = 0;
+    std::unique_ptr<Source> current;
+    std::string current_path;
+    uint64_t current_offset = 0;
+
+    bool open_next();
+
+public:
+    explicit LogReader(const std::string& active_path);
+
+    // Read exactly the given files, in order
+    explicit LogReader(std::vector<std::string> files);
+
+    ~LogReader();
+
+    // Read the next record into `line` (without the newline); false at the end
+    bool next(std::string& line);
+
+    // Segment files the reader will visit, in order
+    const std::vector<std::string>& files() const { return paths; }
+
+    // File and uncompressed byte offset of the record last returned by next()
+    const std::string& record_file() const { return current_path; }
+    uint64_t record_offset() const { return current_offset; }
+};
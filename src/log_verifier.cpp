@@ -0,0 +1,267 @@
+#include "log_verifier.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "log_segments.h"
+#include "mapped_log.h"
+
+using namespace std;
+
+namespace {
+
+// Rehash one block; returns the problem found, or an empty string
+string verify_block(const LogCheckpoint& checkpoint, RecordRange segment, bool ends_segment) {
+    if (checkpoint.offset + checkpoint.bytes > segment.size_bytes()) {
+        return "block extends past the end of segment " + to_string(checkpoint.segment_id);
+    }
+    if (ends_segment && checkpoint.offset + checkpoint.bytes != segment.size_bytes()) {
+        return "unsealed records after the block in segment " + to_string(checkpoint.segment_id);
+    }
+    const char* first = segment.data() + checkpoint.offset;
+    if ((checkpoint.offset != 0 && first[-1] != '\n') || (checkpoint.bytes != 0 && first[checkpoint.bytes - 1] != '\n')) {
+        return "block is not aligned to records";
+    }
+
+    LogHash chain = checkpoint.chain_start;
+    vector<LogHash> leaves;
+    leaves.reserve(checkpoint.records);
+    for (string_view line : RecordRange(first, first + checkpoint.bytes)) {
+        uint64_t number = checkpoint.first_record + leaves.size();
+        string_view record, link;
+        if (!LogChain::split_link(line, record, link)) {
+            return "record " + to_string(number) + " is not sealed";
+        }
+        if (!LogChain::link_matches(link, chain)) {
+            return "record " + to_string(number) + " does not link to the record before it";
+        }
+        chain = LogChain::chain_hash(chain, record);
+        leaves.push_back(chain);
+    }
+    if (leaves.size() != checkpoint.records) {
+        return "block holds " + to_string(leaves.size()) + " records, checkpoint lists " + to_string(checkpoint.records);
+    }
+    if (chain != checkpoint.chain_end) {
+        return "chain value does not match the checkpoint";
+    }
+    if (LogChain::merkle_root(move(leaves)) != checkpoint.merkle_root) {
+        return "Merkle root does not match the checkpoint";
+    }
+    return "";
+}
+
+}
+
+LogVerifier::LogVerifier(string active_path) : active_path(move(active_path)) {}
+
+LogVerifyResult LogVerifier::verify(size_t threads, uint64_t from_checkpoint) {
+    LogVerifyResult result;
+    vector<LogCheckpoint> checkpoints = LogChain::load_checkpoints(LogChain::checkpoint_path_for(active_path));
+    if (checkpoints.empty()) {
+        result.ok = false;
+        result.error = "no checkpoints in " + LogChain::checkpoint_path_for(active_path);
+        return result;
+    }
+    if (from_checkpoint > checkpoints.size()) {
+        result.ok = false;
+        result.error = "checkpoint " + to_string(from_checkpoint) + " does not exist";
+        return result;
+    }
+
+    mutex failure_mtx;
+    auto fail = [&](uint64_t index, const string& error) {
+        lock_guard<mutex> lock(failure_mtx);
+        if (result.ok || index < result.first_bad_checkpoint) {
+            result.ok = false;
+            result.first_bad_checkpoint = index;
+            result.error = "checkpoint " + to_string(index) + ": " + error;
+        }
+    };
+
+    // Continuity: each block starts where the previous one ended
+    size_t count = checkpoints.size();
+    for (size_t k = max<uint64_t>(from_checkpoint, 1); k < count; ++k) {
+        const LogCheckpoint& previous = checkpoints[k - 1];
+        const LogCheckpoint& current = checkpoints[k];
+        if (current.index != k || current.first_record != previous.first_record + previous.records) {
+            fail(k, "checkpoint numbering is not contiguous");
+        }
+        else if (current.chain_start != previous.chain_end) {
+            fail(k, "chain does not continue from the previous checkpoint");
+        }
+        else if (current.segment_id == previous.segment_id ? current.offset != previous.offset + previous.bytes
+                                                            : current.segment_id != previous.segment_id + 1 || current.offset != 0) {
+            fail(k, "unsealed records before the block");
+        }
+    }
+
+    // Segment files by id; the active file has the id after the last closed one
+    map<uint64_t, string> segment_paths;
+    uint64_t active_id = 1;
+    for (const auto& segment : SegmentedLog::load_index(SegmentedLog::index_path_for(active_path))) {
+        segment_paths[segment.id] = SegmentedLog::segment_path(active_path, segment.id);
+        active_id = max(active_id, segment.id + 1);
+    }
+    segment_paths[active_id] = active_path;
+
+    // Work units as in MappedLogReader::parallel_scan: a compressed segment
+    // is inflated once by the worker that takes it, plain segments are
+    // mapped up front and each of their blocks is a unit
+    struct Unit {
+        MappedSegment* segment;
+        vector<size_t> blocks;
+    };
+    vector<unique_ptr<MappedSegment>> segments;
+    vector<Unit> units;
+    for (size_t k = from_checkpoint; k < count;) {
+        uint64_t segment_id = checkpoints[k].segment_id;
+        size_t end = k;
+        while (end < count && checkpoints[end].segment_id == segment_id) {
+            ++end;
+        }
+        auto path = segment_paths.find(segment_id);
+        if (path == segment_paths.end()) {
+            fail(k, "segment " + to_string(segment_id) + " is missing");
+            k = end;
+            continue;
+        }
+        segments.push_back(make_unique<MappedSegment>(path->second));
+        MappedSegment* segment = segments.back().get();
+        if (segment->is_compressed()) {
+            Unit unit{ segment, {} };
+            for (; k < end; ++k) {
+                unit.blocks.push_back(k);
+            }
+            units.push_back(move(unit));
+        }
+        else if (segment->load()) {
+            for (; k < end; ++k) {
+                units.push_back({ segment, { k } });
+            }
+        }
+        else {
+            fail(k, "segment " + to_string(segment_id) + " cannot be read");
+            k = end;
+        }
+    }
+
+    atomic<uint64_t> verified_records{ 0 };
+    atomic<size_t> next_unit{ 0 };
+    auto work = [&]() {
+        for (size_t i; (i = next_unit.fetch_add(1)) < units.size();) {
+            Unit& unit = units[i];
+            if (!unit.segment->load()) {
+                fail(unit.blocks.front(), "segment " + unit.segment->file() + " cannot be read");
+                continue;
+            }
+            for (size_t k : unit.blocks) {
+                // A block followed by one in a later segment must close its own
+                bool ends_segment = k + 1 < count && checkpoints[k + 1].segment_id != checkpoints[k].segment_id;
+                string error = verify_block(checkpoints[k], unit.segment->records(), ends_segment);
+                if (!error.empty()) {
+                    fail(k, error);
+                }
+                else {
+                    verified_records.fetch_add(checkpoints[k].records, memory_order_relaxed);
+                }
+            }
+        }
+    };
+    threads = max<size_t>(1, min(threads, units.size()));
+    vector<thread> workers;
+    for (size_t w = 1; w < threads; ++w) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    segments.clear();
+
+    result.records = verified_records.load();
+    result.checkpoints = result.ok ? count - from_checkpoint : result.first_bad_checkpoint - from_checkpoint;
+    if (!result.ok) {
+        return result;
+    }
+
+    // Tail: records after the last checkpoint can only be checked by their
+    // links until the writer closes their block
+    const LogCheckpoint& last = checkpoints.back();
+    LogHash chain = last.chain_end;
+    for (auto it = segment_paths.find(last.segment_id); it != segment_paths.end(); ++it) {
+        MappedSegment segment(it->second);
+        if (!segment.load()) {
+            result.ok = false;
+            result.error = "segment " + to_string(it->first) + " cannot be read";
+            return result;
+        }
+        RecordRange records = segment.records();
+        uint64_t start = it->first == last.segment_id ? min<uint64_t>(last.offset + last.bytes, records.size_bytes()) : 0;
+        // A record the writer is still appending has no newline yet
+        const char* end = records.data() + records.size_bytes();
+        while (end > records.data() + start && end[-1] != '\n') {
+            --end;
+        }
+        for (string_view line : RecordRange(records.data() + start, end)) {
+            string_view record, link;
+            if (!LogChain::split_link(line, record, link) || !LogChain::link_matches(link, chain)) {
+                result.ok = false;
+                result.error = "record " + to_string(last.first_record + last.records + result.tail_records) +
+                               " after the last checkpoint does not link to the record before it";
+                return result;
+            }
+            chain = LogChain::chain_hash(chain, record);
+            ++result.tail_records;
+        }
+    }
+    return result;
+}
+
+LogVerifyResult LogVerifier::verify_incremental(size_t threads) {
+    string state_path = state_path_for(active_path);
+    vector<LogCheckpoint> checkpoints = LogChain::load_checkpoints(LogChain::checkpoint_path_for(active_path));
+
+    uint64_t from_checkpoint = 0;
+    uint64_t verified_index;
+    string verified_chain;
+    ifstream state(state_path);
+    if (state >> verified_index >> verified_chain) {
+        // The trusted prefix must be exactly what was verified last time
+        LogHash expected;
+        if (verified_index >= checkpoints.size() || !LogChain::from_hex(verified_chain, expected) ||
+            checkpoints[verified_index].chain_end != expected) {
+            LogVerifyResult result;
+            result.ok = false;
+            result.first_bad_checkpoint = verified_index;
+            result.error = "checkpoint " + to_string(verified_index) + " changed since it was verified";
+            return result;
+        }
+        from_checkpoint = verified_index + 1;
+    }
+    state.close();
+
+    LogVerifyResult result = verify(threads, from_checkpoint);
+    if (result.ok && !checkpoints.empty()) {
+        // Checkpoints the writer added during the run are left for the next one
+        const LogCheckpoint& last = checkpoints.back();
+        string tmp_path = state_path + ".tmp";
+        {
+            ofstream out(tmp_path, ios::trunc);
+            out << last.index << ' ' << LogChain::to_hex(last.chain_end) << '\n';
+        }
+        rename(tmp_path.c_str(), state_path.c_str());
+    }
+    return result;
+}
+
+string LogVerifier::state_path_for(const string& active_path) {
+    return LogChain::checkpoint_path_for(active_path) + ".verified";
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "log_chain.h"
+
+// Outcome of verifying a hash-chained log
+struct LogVerifyResult {
+    bool ok = true;
+    uint64_t checkpoints = 0;  // Checkpoints whose blocks were verified
+    uint64_t records = 0;      // Records in those blocks
+    uint64_t tail_records = 0; // Records after the last checkpoint, checked by their links only
+    uint64_t first_bad_checkpoint = UINT64_MAX;
+    std::string error;         // First problem found; empty when ok
+};
+
+// LogVerifier class for auditing a transaction log sealed by LogChain.
+// The checkpoint list is first checked for continuity (chain values, record
+// counts and positions line up, so nothing was dropped between blocks);
+// after that every block is independent and they are verified on parallel
+// workers, each rehashing its records against the block's chain values and
+// Merkle root. verify_incremental() resumes after the last checkpoint a
+// previous run verified, recorded with its chain value in
+// <log>.chain.verified, so routine audits only rehash what is new.
+class LogVerifier {
+private:
+    std::string active_path;
+
+public:
+    explicit LogVerifier(std::string active_path);
+
+    // Verify checkpoints from `from_checkpoint` on, then the unclosed tail
+    LogVerifyResult verify(size_t threads, uint64_t from_checkpoint = 0);
+
+    // Verify what was checkpointed since the last successful incremental run
+    LogVerifyResult verify_incremental(size_t threads);
+
+    static std::string state_path_for(const std::string& active_path);
+};
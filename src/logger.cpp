@@ -0,0 +1,328 @@
+#include "logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <utility>
+
+using namespace std;
+
+namespace {
+
+atomic<uint64_t> next_logger_id{ 1 };
+
+// Bumped when a thread that logged exits, so writers drop its rings
+atomic<size_t> retired_rings{ 0 };
+
+// Rings owned by the calling thread, keyed by Logger id (ids are never
+// reused, unlike addresses)
+struct LocalBuffers {
+    uint64_t last_id = 0;
+    ThreadLogBuffer* last = nullptr;
+    vector<pair<uint64_t, shared_ptr<ThreadLogBuffer>>> owned;
+
+    ~LocalBuffers() {
+        if (!owned.empty()) {
+            owned.clear(); // Before the bump, so the rings look unowned to the writer
+            retired_rings.fetch_add(1, memory_order_release);
+        }
+    }
+};
+
+thread_local LocalBuffers local_buffers;
+
+int64_t steady_now_us() {
+    return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}
+
+LogLine& Logger::local_line() {
+    thread_local LogLine line;
+    return line;
+}
+
+Logger::Logger(const LogRotationPolicy& policy, const ErrorLogPolicy& error_policy, const LogIntegrityPolicy& integrity_policy)
+    : transaction_log("transactions.log", policy), error_log("errors.log", policy), transaction_index(transaction_log),
+      transaction_chain(transaction_log, integrity_policy), error_aggregator(error_policy),
+      logger_id(next_logger_id.fetch_add(1)) {
+    for (size_t i = 0; i < LOG_CATEGORY_COUNT; ++i) {
+        category_levels[i].store(static_cast<uint8_t>(LogLevel::Trace));
+        category_sampling[i].store(1);
+    }
+    writer = thread(&Logger::run_writer, this);
+}
+
+Logger::~Logger() {
+    {
+        lock_guard<MonitoredMutex> lock(writer_mtx);
+        stopping = true;
+    }
+    writer_cv.notify_all();
+    writer.join();
+    {
+        // Report repeats still being counted
+        lock_guard<MonitoredMutex> lock(error_mtx);
+        sweep_errors_locked(INT64_MAX);
+    }
+    {
+        lock_guard<MonitoredMutex> lock(buffers_mtx);
+        for (auto& buffer : buffers) {
+            buffer->closed.store(true, memory_order_release);
+        }
+    }
+}
+
+ThreadLogBuffer& Logger::local_buffer() {
+    LocalBuffers& local = local_buffers;
+    if (local.last_id == logger_id) {
+        return *local.last;
+    }
+
+    // Drop rings of destroyed Loggers before looking up or registering
+    auto& owned = local.owned;
+    owned.erase(remove_if(owned.begin(), owned.end(), [](const auto& entry) { return entry.second->closed.load(memory_order_acquire); }), owned.end());
+
+    auto it = find_if(owned.begin(), owned.end(), [this](const auto& entry) { return entry.first == logger_id; });
+    if (it == owned.end()) {
+        auto buffer = make_shared<ThreadLogBuffer>();
+        {
+            lock_guard<MonitoredMutex> lock(buffers_mtx);
+            buffers.push_back(buffer);
+        }
+        buffers_version.fetch_add(1, memory_order_release);
+        owned.emplace_back(logger_id, move(buffer));
+        it = owned.end() - 1;
+    }
+    local.last_id = logger_id;
+    local.last = it->second.get();
+    return *local.last;
+}
+
+void Logger::wake_writer() {
+    lock_guard<MonitoredMutex> lock(writer_mtx);
+    writer_cv.notify_one();
+}
+
+void Logger::run_writer() {
+    vector<shared_ptr<ThreadLogBuffer>> rings;
+    size_t rings_version = static_cast<size_t>(-1);
+    bool orphans = false; // Rings of exited threads still holding records
+    uint64_t next_write = 0;
+    uint64_t written_before_wait = 0;
+
+    for (;;) {
+        size_t version = buffers_version.load(memory_order_acquire) + retired_rings.load(memory_order_acquire);
+        if (version != rings_version || orphans) {
+            rings.clear();
+            lock_guard<MonitoredMutex> lock(buffers_mtx);
+            // Rings of exited threads are only referenced here once drained
+            buffers.erase(remove_if(buffers.begin(), buffers.end(), [](const auto& buffer) { return buffer.use_count() == 1 && buffer->empty(); }), buffers.end());
+            orphans = any_of(buffers.begin(), buffers.end(), [](const auto& buffer) { return buffer.use_count() == 1; });
+            rings = buffers;
+            rings_version = version;
+        }
+
+        // Each ring is already in sequence order, so repeatedly taking the
+        // ring whose head is the next expected sequence is a k-way merge
+        bool progress = false;
+        int64_t now = static_cast<int64_t>(time(nullptr));
+        for (auto& ring : rings) {
+            ThreadLogBuffer::Slot* slot;
+            while ((slot = ring->front()) != nullptr && slot->sequence == next_write) {
+                transaction_chain.seal(slot->line);
+                transaction_index.add(slot->line.view(), transaction_log.active_size(), now);
+                transaction_log.append(slot->line.data(), slot->line.size());
+                transaction_chain.after_append();
+                ring->pop();
+                ++next_write;
+                progress = true;
+            }
+        }
+        if (progress) {
+            uint64_t requested = read_requested.load(memory_order_seq_cst);
+            if (requested != 0 && next_write >= requested) {
+                lock_guard<MonitoredMutex> lock(writer_mtx);
+                make_readable_locked(next_write);
+            }
+            continue;
+        }
+
+        uint64_t assigned = next_sequence.load(memory_order_acquire);
+        if (next_write < assigned) {
+            // A record with the next sequence is still being published; a
+            // ring registered after our snapshot changed the version
+            this_thread::yield();
+            continue;
+        }
+
+        if (steady_now_us() >= error_sweep_due.load(memory_order_relaxed)) {
+            lock_guard<MonitoredMutex> lock(error_mtx);
+            sweep_errors_locked(steady_now_us());
+        }
+
+        unique_lock<MonitoredMutex> lock(writer_mtx);
+        if (flush_requested > flushed_sequence) {
+            transaction_chain.checkpoint();
+            flushed_sequence = next_write;
+            make_readable_locked(next_write);
+        }
+        else if (read_requested.load(memory_order_relaxed) != 0) {
+            make_readable_locked(next_write);
+        }
+        if (transaction_log.rotate_if_due()) {
+            transaction_chain.after_append();
+        }
+        if (stopping && next_write == next_sequence.load(memory_order_acquire)) {
+            break;
+        }
+
+        // While records keep coming, let them gather for a millisecond, so
+        // producers need not wake us one record at a time
+        if (next_write != written_before_wait) {
+            written_before_wait = next_write;
+            writer_cv.wait_for(lock, chrono::milliseconds(1));
+            continue;
+        }
+
+        // Idle: sleep until a producer, flush() or history() wakes us, or a
+        // summary or rotation is due. Marking ourselves asleep before the
+        // last look at the sequence and sweep time pairs with the checks in
+        // log_transaction() and write_error().
+        writer_sleeping.store(true, memory_order_seq_cst);
+        if (next_sequence.load(memory_order_seq_cst) == next_write) {
+            int64_t sweep_due = error_sweep_due.load(memory_order_seq_cst);
+            int64_t rotation_due = transaction_log.rotation_due_at();
+            if (sweep_due == INT64_MAX && rotation_due == INT64_MAX) {
+                writer_cv.wait(lock);
+            }
+            else {
+                int64_t wait_us = min(sweep_due == INT64_MAX ? INT64_MAX : sweep_due - steady_now_us(),
+                    rotation_due == INT64_MAX ? INT64_MAX : (rotation_due - static_cast<int64_t>(time(nullptr))) * 1000000);
+                if (wait_us > 0) {
+                    writer_cv.wait_for(lock, chrono::microseconds(wait_us));
+                }
+            }
+        }
+        writer_sleeping.store(false, memory_order_relaxed);
+    }
+    transaction_chain.checkpoint();
+    transaction_log.flush();
+}
+
+void Logger::make_readable_locked(uint64_t written) {
+    transaction_log.flush();
+    readable_sequence.store(written, memory_order_release);
+    read_requested.store(0, memory_order_relaxed);
+    flushed_cv.notify_all();
+}
+
+void Logger::write_error(const LogLine& line) {
+    // Deduplicate on the message, not the timestamp prefix
+    string_view message = line.view();
+    size_t body = message.find("] ");
+    if (body != string_view::npos) {
+        message.remove_prefix(body + 2);
+    }
+
+    int64_t now = steady_now_us();
+    {
+        lock_guard<MonitoredMutex> lock(error_mtx);
+        if (now >= error_aggregator.sweep_due()) {
+            sweep_errors_locked(now);
+        }
+        string summary;
+        bool admitted = error_aggregator.admit(message, now, summary);
+        error_sweep_due.store(error_aggregator.sweep_due(), memory_order_seq_cst);
+        if (!summary.empty()) {
+            LogLine summary_line;
+            summary_line.append_timestamp();
+            summary_line.append(summary);
+            error_log.append(summary_line.data(), summary_line.size());
+        }
+        if (admitted) {
+            error_log.append(line.data(), line.size());
+        }
+        if (admitted || !summary.empty()) {
+            error_log.flush();
+            error_log.rotate_if_due();
+        }
+    }
+    // A sleeping writer must learn when the next summary is due
+    if (writer_sleeping.load(memory_order_seq_cst) && error_sweep_due.load(memory_order_relaxed) != INT64_MAX) {
+        wake_writer();
+    }
+}
+
+void Logger::sweep_errors_locked(int64_t now_us) {
+    LogLine summary_line;
+    bool wrote = false;
+    error_aggregator.sweep(now_us, [&](const string& summary) {
+        summary_line.clear();
+        summary_line.append_timestamp();
+        summary_line.append(summary);
+        error_log.append(summary_line.data(), summary_line.size());
+        wrote = true;
+    });
+    error_sweep_due.store(error_aggregator.sweep_due(), memory_order_relaxed);
+    if (wrote) {
+        error_log.flush();
+        error_log.rotate_if_due();
+    }
+}
+
+void Logger::log_transaction(const string& message) {
+    log_transaction<string>(message);
+}
+
+void Logger::log_error(const string& message) {
+    log_error<string>(message);
+}
+
+bool Logger::should_log(LogLevel level, LogCategory category) {
+    size_t index = static_cast<size_t>(category);
+    if (static_cast<uint8_t>(level) < category_levels[index].load(memory_order_relaxed)) {
+        return false;
+    }
+    uint32_t one_in = category_sampling[index].load(memory_order_relaxed);
+    if (one_in <= 1) {
+        return true;
+    }
+    // Per-thread counters keep sampling free of shared writes
+    thread_local array<uint32_t, LOG_CATEGORY_COUNT> counters{};
+    return ++counters[index] % one_in == 0;
+}
+
+void Logger::set_level(LogCategory category, LogLevel level) {
+    category_levels[static_cast<size_t>(category)].store(static_cast<uint8_t>(level), memory_order_relaxed);
+}
+
+void Logger::set_sampling(LogCategory category, uint32_t one_in) {
+    category_sampling[static_cast<size_t>(category)].store(one_in == 0 ? 1 : one_in, memory_order_relaxed);
+}
+
+void Logger::flush() {
+    uint64_t target = next_sequence.load(memory_order_acquire);
+    {
+        unique_lock<MonitoredMutex> lock(writer_mtx);
+        flush_requested = max(flush_requested, target);
+        writer_cv.notify_one();
+        flushed_cv.wait(lock, [&] { return flushed_sequence >= target; });
+    }
+    lock_guard<MonitoredMutex> lock(error_mtx);
+    error_log.flush();
+}
+
+vector<string> Logger::history(int account_id, chrono::system_clock::time_point from, chrono::system_clock::time_point to) {
+    uint64_t target = next_sequence.load(memory_order_acquire);
+    if (readable_sequence.load(memory_order_acquire) < target) {
+        unique_lock<MonitoredMutex> lock(writer_mtx);
+        read_requested.store(max(read_requested.load(memory_order_relaxed), target), memory_order_seq_cst);
+        writer_cv.notify_one();
+        flushed_cv.wait(lock, [&] { return readable_sequence.load(memory_order_acquire) >= target; });
+    }
+    auto seconds = [](chrono::system_clock::time_point point) {
+        return chrono::duration_cast<chrono::seconds>(point.time_since_epoch()).count();
+    };
+    return transaction_index.history(account_id, static_cast<int64_t>(seconds(from)), static_cast<int64_t>(seconds(to)));
+}
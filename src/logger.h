@@ -0,0 +1,166 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "error_aggregator.h"
+#include "lock_monitor.h"
+#include "log_buffer.h"
+#include "log_chain.h"
+#include "log_format.h"
+#include "log_level.h"
+#include "log_segments.h"
+#include "transaction_log_index.h"
+
+// Logger class for transaction and error logging.
+// Transaction records go to a per-thread ring buffer tagged with a global
+// sequence number; a writer thread merges the rings in sequence order into
+// transactions.log, so producers never contend on a shared lock. Both logs
+// rotate into indexed, compressed segments per the LogRotationPolicy, and
+// the writer seals transaction records into a hash chain with Merkle
+// checkpoints per the LogIntegrityPolicy.
+// Records can be filtered by level and category, and Info-level success
+// events sampled, via log<Level>(category, ...). Errors have their own lock
+// and are deduplicated and rate limited per the ErrorLogPolicy.
+class Logger {
+private:
+    SegmentedLog transaction_log;
+    SegmentedLog error_log;
+    TransactionLogIndex transaction_index;
+    LogChain transaction_chain; // Used only by the writer thread
+
+    // Error stream: independent of the transaction rings and writer
+    MonitoredMutex error_mtx{ "Logger::errors" };
+    ErrorAggregator error_aggregator;
+    std::atomic<int64_t> error_sweep_due{ INT64_MAX };
+
+    const uint64_t logger_id;
+    std::atomic<uint64_t> next_sequence{ 0 };
+
+    std::vector<std::shared_ptr<ThreadLogBuffer>> buffers;
+    std::atomic<size_t> buffers_version{ 0 }; // Bumped when a ring registers
+    MonitoredMutex buffers_mtx{ "Logger::buffers" };
+
+    // Runtime filtering: minimum level and 1-in-N sampling of sub-Audit
+    // records, per category
+    std::array<std::atomic<uint8_t>, LOG_CATEGORY_COUNT> category_levels;
+    std::array<std::atomic<uint32_t>, LOG_CATEGORY_COUNT> category_sampling;
+
+    // Writer state shared with flush() and history()
+    std::thread writer;
+    MonitoredMutex writer_mtx{ "Logger::writer" };
+    std::condition_variable_any writer_cv;
+    std::condition_variable_any flushed_cv;
+    bool stopping = false;
+    uint64_t flush_requested = 0;
+    uint64_t flushed_sequence = 0;
+    std::atomic<bool> writer_sleeping{ false };      // Waiting with every record written
+    std::atomic<uint64_t> read_requested{ 0 };       // Sequence history() waits for; 0 for none
+    std::atomic<uint64_t> readable_sequence{ 0 };    // Records below it are in the file
+
+    // Scratch record reused by every error log call on this thread
+    static LogLine& local_line();
+
+    // This thread's ring for this Logger, registered on first use
+    ThreadLogBuffer& local_buffer();
+
+    void wake_writer();
+    void run_writer();
+
+    // Push written records to the file for history() and release its
+    // waiters; caller holds writer_mtx
+    void make_readable_locked(uint64_t written);
+
+    void write_error(const LogLine& line);
+
+    // Write summaries of closed dedup windows; caller holds error_mtx
+    void sweep_errors_locked(int64_t now_us);
+
+    // Runtime level and sampling check for records below Audit
+    bool should_log(LogLevel level, LogCategory category);
+
+public:
+    Logger(const LogRotationPolicy& policy = {}, const ErrorLogPolicy& error_policy = {},
+           const LogIntegrityPolicy& integrity_policy = {});
+
+    ~Logger();
+
+    void log_transaction(const std::string& message);
+
+    void log_error(const std::string& message);
+
+    // Format the parts (strings, integers, floats) straight into the
+    // record buffer, e.g. log_transaction("Deposit: Account ID=", id)
+    template <typename... Parts>
+    void log_transaction(const Parts&... parts) {
+        ThreadLogBuffer& buffer = local_buffer();
+        if (buffer.full()) {
+            wake_writer();
+        }
+        ThreadLogBuffer::Slot& slot = buffer.claim();
+        slot.line.clear();
+        slot.line.append_timestamp();
+        slot.line.append_all(parts...);
+        // Pairs with the writer marking itself asleep before it last
+        // checked for new sequences: one of the two sees the other
+        slot.sequence = next_sequence.fetch_add(1, std::memory_order_seq_cst);
+        buffer.publish();
+        if (writer_sleeping.load(std::memory_order_seq_cst)) {
+            wake_writer();
+        }
+    }
+
+    template <typename... Parts>
+    void log_error(const Parts&... parts) {
+        LogLine& line = local_line();
+        line.clear();
+        line.append_timestamp();
+        line.append_all(parts...);
+        write_error(line);
+    }
+
+    // Leveled record: Warning and Error go to errors.log, the rest to
+    // transactions.log. Levels below BANKING_LOG_LEVEL compile away; below
+    // Audit, the category's runtime level and sampling also apply.
+    template <LogLevel Level, typename... Parts>
+    void log(LogCategory category, const Parts&... parts) {
+        if constexpr (log_level_compiled_in(Level)) {
+            if constexpr (Level < LogLevel::Audit) {
+                if (!should_log(Level, category)) {
+                    return;
+                }
+            }
+            if constexpr (Level >= LogLevel::Warning) {
+                log_error(parts...);
+            }
+            else {
+                log_transaction(parts...);
+            }
+        }
+    }
+
+    // Drop records of the category below `level` (Audit and above always pass)
+    void set_level(LogCategory category, LogLevel level);
+
+    // Keep one in `one_in` records of the category below Audit; 1 keeps all
+    void set_sampling(LogCategory category, uint32_t one_in);
+
+    // Wait until every transaction record logged before the call is
+    // written and checkpointed, then flush both files to disk
+    void flush();
+
+    // Transaction records mentioning the account logged in [from, to],
+    // oldest first, read through the per-account index. Sees every record
+    // logged before the call without waiting for a checkpoint or sync.
+    std::vector<std::string> history(int account_id,
+                                     std::chrono::system_clock::time_point from = std::chrono::system_clock::time_point::min(),
+                                     std::chrono::system_clock::time_point to = std::chrono::system_clock::time_point::max());
+};
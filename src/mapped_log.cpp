@@ -0,0 +1,125 @@
+#include "mapped_log.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef BANKING_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "log_segments.h"
+
+using namespace std;
+
+MappedFile::MappedFile(const string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void* address = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED) {
+            madvise(address, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+            base = static_cast<const char*>(address);
+            length = static_cast<size_t>(info.st_size);
+        }
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (base != nullptr) {
+        munmap(const_cast<char*>(base), length);
+    }
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept : base(other.base), length(other.length) {
+    other.base = nullptr;
+    other.length = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        if (base != nullptr) {
+            munmap(const_cast<char*>(base), length);
+        }
+        base = other.base;
+        length = other.length;
+        other.base = nullptr;
+        other.length = 0;
+    }
+    return *this;
+}
+
+vector<RecordRange> RecordRange::split(size_t parts) const {
+    vector<RecordRange> ranges;
+    size_t total = size_bytes();
+    parts = max<size_t>(1, parts);
+    const char* start = first;
+    for (size_t i = 1; i <= parts && start < last; ++i) {
+        const char* cut = i == parts ? last : first + total * i / parts;
+        if (cut < start) {
+            continue;
+        }
+        // Move the cut just past the next newline so no record is split
+        const void* newline = cut == last ? nullptr : memchr(cut, '\n', static_cast<size_t>(last - cut));
+        cut = newline ? static_cast<const char*>(newline) + 1 : last;
+        ranges.emplace_back(start, cut);
+        start = cut;
+    }
+    return ranges;
+}
+
+MappedSegment::MappedSegment(string path) : path(move(path)) {
+    struct stat info;
+    // The compressor may have replaced the raw segment since the index was read
+    if (stat(this->path.c_str(), &info) != 0 && stat((this->path + ".gz").c_str(), &info) == 0) {
+        this->path += ".gz";
+    }
+    compressed = this->path.size() > 3 && this->path.compare(this->path.size() - 3, 3, ".gz") == 0;
+}
+
+bool MappedSegment::load() {
+    if (loaded) {
+        return true;
+    }
+    if (!compressed) {
+        mapped = MappedFile(path);
+        loaded = true; // An empty file maps to nothing but is still readable
+        return true;
+    }
+#ifdef BANKING_HAVE_ZLIB
+    gzFile in = gzopen(path.c_str(), "rb");
+    if (in == nullptr) {
+        return false;
+    }
+    gzbuffer(in, 1 << 17);
+    char chunk[1 << 16];
+    int n;
+    while ((n = gzread(in, chunk, sizeof(chunk))) > 0) {
+        inflated.append(chunk, static_cast<size_t>(n));
+    }
+    gzclose(in);
+    loaded = n == 0;
+    return loaded;
+#else
+    return false;
+#endif
+}
+
+RecordRange MappedSegment::records() const {
+    if (compressed) {
+        return RecordRange(inflated.data(), inflated.data() + inflated.size());
+    }
+    return RecordRange(mapped.data(), mapped.data() + mapped.size());
+}
+
+MappedLogReader::MappedLogReader(const string& active_path) {
+    for (const auto& segment : SegmentedLog::load_index(SegmentedLog::index_path_for(active_path))) {
+        segments.push_back(make_unique<MappedSegment>(segment.path));
+    }
+    segments.push_back(make_unique<MappedSegment>(active_path));
+}
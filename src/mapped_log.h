@@ -0,0 +1,183 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// MappedFile class for a read-only memory map of a whole file
+class MappedFile {
+private:
+    const char* base = nullptr;
+    size_t length = 0;
+
+public:
+    MappedFile() = default;
+
+    explicit MappedFile(const std::string& path);
+
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool is_open() const { return base != nullptr; }
+    const char* data() const { return base; }
+    size_t size() const { return length; }
+};
+
+// RecordRange class for the newline-terminated records in a byte range.
+// Iterating yields views into the underlying bytes; nothing is copied.
+class RecordRange {
+private:
+    const char* first = nullptr;
+    const char* last = nullptr;
+
+public:
+    class iterator {
+    private:
+        const char* position;
+        const char* end;
+        const char* line_end;
+
+        void find_line_end() {
+            const void* newline = position == end ? nullptr : std::memchr(position, '\n', static_cast<size_t>(end - position));
+            line_end = newline ? static_cast<const char*>(newline) : end;
+        }
+
+    public:
+        iterator(const char* position, const char* end) : position(position), end(end) { find_line_end(); }
+
+        std::string_view operator*() const { return std::string_view(position, static_cast<size_t>(line_end - position)); }
+
+        iterator& operator++() {
+            position = line_end == end ? end : line_end + 1;
+            find_line_end();
+            return *this;
+        }
+
+        bool operator==(const iterator& other) const { return position == other.position; }
+        bool operator!=(const iterator& other) const { return position != other.position; }
+    };
+
+    RecordRange() = default;
+    RecordRange(const char* first, const char* last) : first(first), last(last) {}
+
+    iterator begin() const { return iterator(first, last); }
+    iterator end() const { return iterator(last, last); }
+    const char* data() const { return first; }
+    size_t size_bytes() const { return static_cast<size_t>(last - first); }
+
+    // Split into at most `parts` ranges that start and end on record boundaries
+    std::vector<RecordRange> split(size_t parts) const;
+};
+
+// MappedSegment class for one log segment. Plain segments are mapped and read
+// in place; compressed ones are inflated into memory once, on load().
+class MappedSegment {
+private:
+    std::string path;
+    bool compressed = false;
+    MappedFile mapped;
+    std::string inflated;
+    bool loaded = false;
+
+public:
+    explicit MappedSegment(std::string path);
+
+    // Map or inflate the segment; false if it cannot be read
+    bool load();
+
+    bool is_compressed() const { return compressed; }
+    const std::string& file() const { return path; }
+
+    // Valid after load()
+    RecordRange records() const;
+};
+
+// MappedLogReader class for replaying and analysing a segmented log at disk
+// bandwidth: every closed segment (oldest first) followed by the active file.
+class MappedLogReader {
+public:
+    // Plain segments are split into chunks of about this size for parallel scans
+    static constexpr size_t SCAN_CHUNK_BYTES = 4u << 20;
+
+private:
+    std::vector<std::unique_ptr<MappedSegment>> segments;
+
+public:
+    explicit MappedLogReader(const std::string& active_path);
+
+    size_t segment_count() const { return segments.size(); }
+    MappedSegment& segment(size_t index) { return *segments[index]; }
+
+    // Visit every record in log order on the calling thread
+    template <typename Fn>
+    void scan(Fn&& fn) {
+        for (auto& segment : segments) {
+            if (segment->load()) {
+                for (std::string_view record : segment->records()) {
+                    fn(record);
+                }
+            }
+        }
+    }
+
+    // Visit every record on `threads` workers as fn(worker_index, record).
+    // Records within a chunk arrive in log order; chunks run concurrently, so
+    // fn must only touch per-worker state (merge it after the call).
+    template <typename Fn>
+    void parallel_scan(size_t threads, Fn&& fn) {
+        struct Unit {
+            MappedSegment* segment;
+            RecordRange range; // Empty for compressed segments: inflated by the worker
+        };
+        std::vector<Unit> units;
+        for (auto& segment : segments) {
+            if (segment->is_compressed()) {
+                units.push_back({ segment.get(), RecordRange() });
+            }
+            else if (segment->load()) {
+                RecordRange all = segment->records();
+                for (const RecordRange& range : all.split(all.size_bytes() / SCAN_CHUNK_BYTES + 1)) {
+                    units.push_back({ segment.get(), range });
+                }
+            }
+        }
+
+        threads = std::max<size_t>(1, std::min(threads, units.size()));
+        std::atomic<size_t> next_unit{ 0 };
+        auto work = [&](size_t worker_index) {
+            for (size_t i; (i = next_unit.fetch_add(1)) < units.size();) {
+                Unit& unit = units[i];
+                RecordRange range = unit.range;
+                if (unit.segment->is_compressed()) {
+                    if (!unit.segment->load()) {
+                        continue;
+                    }
+                    range = unit.segment->records();
+                }
+                for (std::string_view record : range) {
+                    fn(worker_index, record);
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (size_t w = 1; w < threads; ++w) {
+            workers.emplace_back(work, w);
+        }
+        work(0);
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+};
@@ -0,0 +1,33 @@
+#include "memory_manager.h"
+
+#include <iostream>
+
+using namespace std;
+
+void MemoryManager::replace_page_locked(int account_id, float balance) {
+    memory.pop_front(); // Remove the least recently used page
+    memory.push_back({ account_id, balance });
+}
+
+void MemoryManager::store_data_in_page(int account_id, float balance) {
+    lock_guard<MonitoredMutex> lock(mtx);
+    if (memory.size() >= max_pages) {
+        replace_page_locked(account_id, balance);
+    }
+    else {
+        memory.push_back({ account_id, balance });
+    }
+}
+
+void MemoryManager::replace_page(int account_id, float balance) {
+    lock_guard<MonitoredMutex> lock(mtx);
+    replace_page_locked(account_id, balance);
+}
+
+void MemoryManager::display_memory_map() {
+    lock_guard<MonitoredMutex> lock(mtx);
+    cout << "Memory Map:" << endl;
+    for (const auto& page : memory) {
+        cout << "Account ID: " << page.account_id << ", Balance: " << page.balance << endl;
+    }
+}
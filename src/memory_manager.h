@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+
+#include "lock_monitor.h"
+
+// MemoryManager class for paging and memory management
+class MemoryManager {
+private:
+    struct Page {
+        int account_id;
+        float balance;
+    };
+
+    std::list<Page> memory;
+    size_t max_pages;
+    MonitoredMutex mtx{ "MemoryManager" };
+
+    // Caller must hold `mtx`
+    void replace_page_locked(int account_id, float balance);
+
+public:
+    MemoryManager(size_t max_pages) : max_pages(max_pages) {}
+
+    void store_data_in_page(int account_id, float balance);
+
+    void replace_page(int account_id, float balance);
+
+    void display_memory_map();
+};
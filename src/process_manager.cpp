@@ -0,0 +1,37 @@
+#include "process_manager.h"
+
+using namespace std;
+
+int ProcessManager::create_transaction_process(int customer_id, int account_id) {
+    lock_guard<MonitoredMutex> lock(mtx);
+    int transaction_id = next_transaction_id++;
+    process_table.emplace(transaction_id, Process(transaction_id, "Ready", account_id, customer_id));
+    return transaction_id;
+}
+
+void ProcessManager::terminate_transaction_process(int transaction_id) {
+    lock_guard<MonitoredMutex> lock(mtx);
+    auto it = process_table.find(transaction_id);
+    if (it != process_table.end()) {
+        it->second.state = "Terminated";
+        process_table.erase(it);
+    }
+}
+
+void ProcessManager::update_process_state(int transaction_id, const string& state) {
+    lock_guard<MonitoredMutex> lock(mtx);
+    auto it = process_table.find(transaction_id);
+    if (it != process_table.end()) {
+        it->second.state = state;
+    }
+}
+
+void ProcessManager::remove_process(int transaction_id) {
+    lock_guard<MonitoredMutex> lock(mtx);
+    process_table.erase(transaction_id);
+}
+
+map<int, ProcessManager::Process> ProcessManager::get_process_table() {
+    lock_guard<MonitoredMutex> lock(mtx);
+    return process_table;
+}
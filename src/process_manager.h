@@ -0,0 +1,37 @@
+#pragma once
+
+#include <map>
+#include <string>
+
+#include "lock_monitor.h"
+
+// ProcessManager class for process creation and management
+class ProcessManager {
+private:
+    struct Process {
+        int transaction_id;
+        std::string state;
+        int account_id;
+        int customer_id;
+
+        // Constructor to initialize member variables
+        Process(int t_id, const std::string& st, int a_id, int c_id)
+            : transaction_id(t_id), state(st), account_id(a_id), customer_id(c_id) {
+        }
+    };
+
+    std::map<int, Process> process_table;
+    MonitoredMutex mtx{ "ProcessManager" };
+    int next_transaction_id = 1;
+
+public:
+    int create_transaction_process(int customer_id, int account_id);
+
+    void terminate_transaction_process(int transaction_id);
+
+    void update_process_state(int transaction_id, const std::string& state);
+
+    void remove_process(int transaction_id);
+
+    std::map<int, Process> get_process_table();
+};
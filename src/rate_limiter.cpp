@@ -0,0 +1,119 @@
+#include "rate_limiter.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+
+using namespace std;
+
+namespace {
+
+size_t table_size(double rate, size_t max_tracked) {
+    // At most half full, so probe runs stay short
+    return rate > 0 ? bit_ceil(max<size_t>(max_tracked, 8) * 2) : 1;
+}
+
+// Nanoseconds as int64, clamped in double first: a tiny rate or a huge
+// burst would otherwise overflow the conversion. A bucket may stand at
+// now + tolerance and then move one interval on, so both stay below a
+// quarter of the range and that sum stays short of RECLAIMING.
+int64_t clamped_ns(double ns) {
+    constexpr double LIMIT = static_cast<double>(INT64_MAX / 4);
+    return static_cast<int64_t>(min(max(ns, 1.0), LIMIT));
+}
+
+}
+
+RateLimiter::RateLimiter(double rate, double burst, size_t max_tracked)
+    : interval_ns(rate > 0 ? clamped_ns(1e9 / rate) : 0),
+      tolerance_ns(clamped_ns(max(1.0, burst) * static_cast<double>(interval_ns))),
+      mask(table_size(rate, max_tracked) - 1), buckets(rate > 0 ? make_unique<Bucket[]>(mask + 1) : nullptr) {
+    overflow.id.store(OVERFLOW_ID, memory_order_relaxed);
+}
+
+RateLimiter::Bucket* RateLimiter::find(int64_t id, int64_t now_ns, bool claim) {
+    // Fibonacci hashing: account IDs are sequential
+    size_t start = static_cast<size_t>((static_cast<uint64_t>(id) * 0x9e3779b97f4a7c15ull) >> 32);
+    Bucket* idle = nullptr;
+    int64_t idle_full_at = 0;
+    for (size_t i = 0; i < PROBES; ++i) {
+        Bucket& bucket = buckets[(start + i) & mask];
+        int64_t current = bucket.id.load(memory_order_acquire);
+        if (current == id) {
+            return &bucket;
+        }
+        if (current == EMPTY) {
+            // Slots are never freed, so the ID is not further along the run
+            if (!claim) {
+                return nullptr;
+            }
+            // If another thread got there first, `current` says for which ID
+            if (bucket.id.compare_exchange_strong(current, id, memory_order_acq_rel) || current == id) {
+                return &bucket;
+            }
+            continue;
+        }
+        int64_t full_at = bucket.full_at_ns.load(memory_order_acquire);
+        if (claim && idle == nullptr && full_at <= now_ns) {
+            idle = &bucket;
+            idle_full_at = full_at;
+        }
+    }
+    // Take over the idle bucket as it stands: full, just like a new one.
+    // Its owner's in-flight calls see RECLAIMING or the new ID and retry.
+    if (idle != nullptr && idle->full_at_ns.compare_exchange_strong(idle_full_at, RECLAIMING, memory_order_acq_rel)) {
+        idle->id.store(id, memory_order_release);
+        idle->full_at_ns.store(idle_full_at, memory_order_release);
+        return idle;
+    }
+    return nullptr;
+}
+
+bool RateLimiter::try_acquire(int64_t id, int64_t now_ns) {
+    if (!enabled()) {
+        return true;
+    }
+    for (;;) {
+        Bucket* bucket = find(id, now_ns, true);
+        int64_t owner = id;
+        if (bucket == nullptr) {
+            overflow_count.fetch_add(1, memory_order_relaxed);
+            bucket = &overflow;
+            owner = OVERFLOW_ID;
+        }
+        int64_t full_at = bucket->full_at_ns.load(memory_order_acquire);
+        while (full_at != RECLAIMING) {
+            int64_t next = max(full_at, now_ns) + interval_ns;
+            if (next - now_ns > tolerance_ns) {
+                rejected_count.fetch_add(1, memory_order_relaxed);
+                return false;
+            }
+            if (!bucket->full_at_ns.compare_exchange_weak(full_at, next, memory_order_acq_rel)) {
+                continue;
+            }
+            if (bucket->id.load(memory_order_acquire) == owner) {
+                return true;
+            }
+            // Reclaimed by another ID since find(): return its token and look again
+            bucket->full_at_ns.fetch_sub(interval_ns, memory_order_relaxed);
+            break;
+        }
+    }
+}
+
+void RateLimiter::refund(int64_t id) {
+    if (!enabled()) {
+        return;
+    }
+    // A bucket just charged is not idle, so it still belongs to the ID
+    Bucket* bucket = find(id, 0, false);
+    if (bucket == nullptr) {
+        bucket = &overflow;
+    }
+    int64_t full_at = bucket->full_at_ns.load(memory_order_relaxed);
+    while (full_at != RECLAIMING) {
+        if (bucket->full_at_ns.compare_exchange_weak(full_at, full_at - interval_ns, memory_order_relaxed)) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// How fast each customer and each account may call the SystemCallInterface
+struct RateLimitPolicy {
+    double customer_rate = 0.0;   // Sustained calls per second per customer; 0 disables
+    double customer_burst = 100.0; // Bucket size per customer
+    double account_rate = 0.0;    // Sustained calls per second per account; 0 disables
+    double account_burst = 100.0;
+    size_t max_tracked = 1 << 16; // Active IDs with their own bucket per limiter; further IDs share one
+};
+
+// Calls turned away by the rate limits since start
+struct RateLimitMetrics {
+    uint64_t customer_rejected = 0;
+    uint64_t account_rejected = 0;
+    uint64_t overflowed = 0; // Charged to a limiter's shared overflow bucket because the table was full
+};
+
+// RateLimiter class: one token bucket per ID, safe to use from any thread.
+// A bucket is a single word, the time it will be full again (the generic
+// cell rate algorithm): taking a token moves it one interval forward from
+// now or from where it stood, whichever is later, and fails if that puts
+// it more than the burst ahead of now. Refill is implied by the clock, so
+// there is no timer, and a call costs one compare-and-swap. Buckets live
+// in a fixed open-addressing table that IDs claim on first use. A bucket
+// that has refilled completely is in the same state as a new one, so a
+// new ID whose probe run is taken over reclaims such an idle bucket. If
+// none is idle, the ID is charged to one overflow bucket shared by all
+// such IDs, so a flood of new IDs is limited rather than let through.
+class RateLimiter {
+private:
+    static constexpr int64_t EMPTY = INT64_MIN;
+    static constexpr int64_t OVERFLOW_ID = INT64_MIN + 1;
+    static constexpr int64_t RECLAIMING = INT64_MAX; // full_at_ns while a bucket changes hands
+    static constexpr size_t PROBES = 16;             // Slots tried per ID before it overflows
+
+    struct Bucket {
+        std::atomic<int64_t> id{ EMPTY };
+        std::atomic<int64_t> full_at_ns{ 0 };
+    };
+
+    const int64_t interval_ns;  // Refill time of one token
+    const int64_t tolerance_ns; // How far ahead of now a bucket may run
+    const size_t mask;
+    std::unique_ptr<Bucket[]> buckets; // Null when disabled
+    Bucket overflow;
+    std::atomic<uint64_t> rejected_count{ 0 };
+    std::atomic<uint64_t> overflow_count{ 0 };
+
+    // The ID's bucket. With `claim`, a missing ID takes a free or idle slot;
+    // nullptr if there is none (or without `claim`, if it has no bucket)
+    Bucket* find(int64_t id, int64_t now_ns, bool claim);
+
+public:
+    // `rate` tokens per second up to `burst`; a rate of 0 admits everything
+    RateLimiter(double rate, double burst, size_t max_tracked);
+
+    RateLimiter(const RateLimiter&) = delete;
+    RateLimiter& operator=(const RateLimiter&) = delete;
+
+    bool enabled() const { return buckets != nullptr; }
+
+    // Take a token from the ID's bucket at `now_ns`; false if it is empty
+    bool try_acquire(int64_t id, int64_t now_ns);
+
+    // Give back a token taken by try_acquire()
+    void refund(int64_t id);
+
+    uint64_t rejected() const { return rejected_count.load(std::memory_order_relaxed); }
+    uint64_t overflowed() const { return overflow_count.load(std::memory_order_relaxed); }
+
+    static int64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
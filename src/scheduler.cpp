@@ -0,0 +1,44 @@
+#include "scheduler.h"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+
+void Scheduler::add_to_ready_queue(int transaction_id) {
+    lock_guard<MonitoredMutex> lock(mtx);
+    ready_queue.push(transaction_id);
+    cv.notify_one();
+}
+
+void Scheduler::stop() {
+    running = false;
+    cv.notify_all();
+}
+
+void Scheduler::run() {
+    while (running) {
+        unique_lock<MonitoredMutex> lock(mtx);
+        cv.wait(lock, [this] { return !ready_queue.empty() || !running; });
+
+        if (!running) break;
+
+        int transaction_id = ready_queue.front();
+        ready_queue.pop();
+        lock.unlock();
+
+        process_manager.update_process_state(transaction_id, "Running");
+        this_thread::sleep_for(chrono::milliseconds(time_slice)); // Simulate process execution
+        process_manager.update_process_state(transaction_id, "Terminated");
+
+        gantt_chart.push_back({ transaction_id, "Running" });
+    }
+}
+
+void Scheduler::display_gantt_chart() {
+    cout << "Gantt Chart:" << endl;
+    for (const auto& entry : gantt_chart) {
+        cout << "Transaction ID: " << entry.first << " - State: " << entry.second << endl;
+    }
+}
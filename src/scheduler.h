@@ -0,0 +1,34 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "lock_monitor.h"
+#include "process_manager.h"
+
+// Scheduler class for CPU scheduling
+class Scheduler {
+private:
+    std::queue<int> ready_queue;
+    MonitoredMutex mtx{ "Scheduler" };
+    std::condition_variable_any cv;
+    std::atomic<bool> running;
+    ProcessManager& process_manager;
+    std::vector<std::pair<int, std::string>> gantt_chart;
+    int time_slice;
+
+public:
+    Scheduler(ProcessManager& pm, int ts) : running(true), process_manager(pm), time_slice(ts) {}
+
+    void add_to_ready_queue(int transaction_id);
+
+    void stop();
+
+    void run();
+
+    void display_gantt_chart();
+};
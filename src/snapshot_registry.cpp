@@ -0,0 +1,92 @@
+#include "snapshot_registry.h"
+
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+
+namespace {
+
+atomic<uint64_t> next_registry_id{ 1 };
+
+// Slots owned by the calling thread, keyed by registry id (ids are never
+// reused, unlike addresses)
+struct LocalSlots {
+    uint64_t last_id = 0;
+    SnapshotRegistry::Slot* last = nullptr;
+    vector<pair<uint64_t, shared_ptr<SnapshotRegistry::Slot>>> owned;
+};
+
+thread_local LocalSlots local_slots;
+
+}
+
+SnapshotRegistry::SnapshotRegistry() : registry_id(next_registry_id.fetch_add(1)) {}
+
+SnapshotRegistry::~SnapshotRegistry() {
+    lock_guard<mutex> lock(slots_mtx);
+    for (auto& slot : slots) {
+        slot->closed.store(true, memory_order_release);
+    }
+}
+
+SnapshotRegistry::Slot& SnapshotRegistry::local_slot() {
+    LocalSlots& local = local_slots;
+    if (local.last_id == registry_id) {
+        return *local.last;
+    }
+
+    // Drop slots of destroyed registries before looking up or registering
+    auto& owned = local.owned;
+    owned.erase(remove_if(owned.begin(), owned.end(), [](const auto& entry) { return entry.second->closed.load(memory_order_acquire); }), owned.end());
+
+    auto it = find_if(owned.begin(), owned.end(), [this](const auto& entry) { return entry.first == registry_id; });
+    if (it == owned.end()) {
+        auto slot = make_shared<Slot>();
+        {
+            lock_guard<mutex> lock(slots_mtx);
+            // Slots of exited threads are only referenced here
+            slots.erase(remove_if(slots.begin(), slots.end(), [](const auto& entry) { return entry.use_count() == 1; }), slots.end());
+            slots.push_back(slot);
+        }
+        owned.emplace_back(registry_id, move(slot));
+        it = owned.end() - 1;
+    }
+    local.last_id = registry_id;
+    local.last = it->second.get();
+    return *local.last;
+}
+
+uint64_t SnapshotRegistry::begin_read() {
+    Slot& slot = local_slot();
+    if (slot.depth++ != 0) {
+        return slot.reading.load(memory_order_relaxed);
+    }
+    // Announce the snapshot, then check no collector has moved past it in
+    // the meantime: either the collector's slot scan sees this announcement,
+    // or this load sees its raised horizon and the read starts over later
+    uint64_t snapshot = clock.load(memory_order_seq_cst);
+    slot.reading.store(snapshot, memory_order_seq_cst);
+    while (horizon.load(memory_order_seq_cst) > snapshot) {
+        snapshot = clock.load(memory_order_seq_cst);
+        slot.reading.store(snapshot, memory_order_seq_cst);
+    }
+    return snapshot;
+}
+
+void SnapshotRegistry::end_read() {
+    Slot& slot = local_slot();
+    if (--slot.depth == 0) {
+        slot.reading.store(IDLE, memory_order_release);
+    }
+}
+
+uint64_t SnapshotRegistry::collect_horizon() {
+    uint64_t oldest = clock.load(memory_order_seq_cst);
+    horizon.store(oldest, memory_order_seq_cst);
+    lock_guard<mutex> lock(slots_mtx);
+    for (const auto& slot : slots) {
+        oldest = min(oldest, slot->reading.load(memory_order_seq_cst));
+    }
+    return oldest;
+}
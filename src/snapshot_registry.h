@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// SnapshotRegistry class for multi-version reads.
+// Writers stamp each commit with the next value of a commit clock and
+// publish it once all of the commit's versions are installed; a reader takes
+// the clock as its snapshot and reads, for every record, the newest version
+// stamped at or before it. Each reading thread announces its snapshot in a
+// per-thread slot so the collector knows which old versions are still
+// visible. Readers never lock or write shared state other than their slot.
+class SnapshotRegistry {
+public:
+    static constexpr uint64_t IDLE = UINT64_MAX;
+
+    struct Slot {
+        alignas(64) std::atomic<uint64_t> reading{ IDLE };
+        uint32_t depth = 0; // Nested reads on the owning thread share one snapshot
+        std::atomic<bool> closed{ false }; // Set when the registry is destroyed
+    };
+
+    // Scoped snapshot on the calling thread
+    class Reader {
+    private:
+        SnapshotRegistry& registry;
+        uint64_t snapshot;
+
+    public:
+        explicit Reader(SnapshotRegistry& registry) : registry(registry), snapshot(registry.begin_read()) {}
+        ~Reader() { registry.end_read(); }
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        uint64_t commit() const { return snapshot; }
+    };
+
+private:
+    std::atomic<uint64_t> clock{ 0 };   // Last published commit
+    std::atomic<uint64_t> horizon{ 0 }; // Readers must start at or after this commit
+    const uint64_t registry_id;
+
+    std::vector<std::shared_ptr<Slot>> slots;
+    std::mutex slots_mtx;
+
+    // This thread's slot for this registry, registered on first use
+    Slot& local_slot();
+
+public:
+    SnapshotRegistry();
+
+    ~SnapshotRegistry();
+
+    uint64_t begin_read();
+    void end_read();
+
+    // Writers are serialized by the caller: stamp versions with next_commit()
+    // and publish() it once they are all installed
+    uint64_t next_commit() const { return clock.load(std::memory_order_relaxed) + 1; }
+    void publish(uint64_t commit) { clock.store(commit, std::memory_order_release); }
+
+    uint64_t last_commit() const { return clock.load(std::memory_order_acquire); }
+
+    // Oldest snapshot any current or future reader can hold. A version
+    // superseded by one stamped at or before it is invisible to all of them.
+    uint64_t collect_horizon();
+};
@@ -0,0 +1,333 @@
+#include "system_call_interface.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+
+namespace {
+
+// What an idempotency key was used for, so a reused key cannot replay the
+// result of a different call
+uint64_t request_fingerprint(uint64_t op, int first, int second, float amount) {
+    uint64_t hash = op;
+    for (uint64_t part : { static_cast<uint64_t>(static_cast<uint32_t>(first)), static_cast<uint64_t>(static_cast<uint32_t>(second)),
+                           static_cast<uint64_t>(bit_cast<uint32_t>(amount)) }) {
+        hash = (hash ^ part) * 0x100000001b3ull;
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
+
+// The fingerprint and result a batch operation would have as a single
+// call, so a key works the same on both paths
+uint64_t batch_fingerprint(const AccountManager::Operation& op) {
+    return request_fingerprint(static_cast<uint64_t>(op.type) + 1, op.account_id,
+        op.type == AccountManager::Operation::Transfer ? op.to_account_id : 0, op.amount);
+}
+
+int64_t batch_result(const AccountManager::Operation& op) {
+    if (op.type == AccountManager::Operation::CreateAccount) {
+        return op.ok ? op.result_account_id : -1;
+    }
+    return op.ok ? 1 : 0;
+}
+
+void replay_result(AccountManager::Operation& op, int64_t result) {
+    if (op.type == AccountManager::Operation::CreateAccount) {
+        op.result_account_id = static_cast<int>(result);
+        op.ok = result != -1;
+        return;
+    }
+    op.ok = result != 0;
+}
+
+// Keys claimed by a batch, with the operation holding each; those still
+// held when the batch unwinds are abandoned, as IdempotencyTable::Guard does
+struct BatchClaims {
+    IdempotencyTable& table;
+    vector<pair<size_t, uint64_t>> held;
+
+    ~BatchClaims() {
+        for (const auto& claim : held) {
+            table.abandon(claim.second);
+        }
+    }
+};
+
+}
+
+template <typename Admit, typename Run>
+int64_t SystemCallInterface::run_once(uint64_t key, uint64_t fingerprint, int64_t failed, Admit admit, Run run) {
+    if (key == 0) {
+        return admit() ? run() : failed;
+    }
+    int64_t result = failed;
+    switch (idempotency.begin(key, fingerprint, result)) {
+    case IdempotencyTable::Claim::Duplicate:
+        return result;
+    case IdempotencyTable::Claim::Mismatch:
+        errorHandler.handle_error("Request rejected: Idempotency key " + to_string(key) + " was used for a different request");
+        return failed;
+    case IdempotencyTable::Claim::Busy:
+        errorHandler.handle_error("Request rejected: Idempotency key " + to_string(key) + " is still in progress");
+        return failed;
+    case IdempotencyTable::Claim::New:
+        break;
+    }
+    // Not recorded if turned away or unwound: a later retry should run
+    IdempotencyTable::Guard claim(idempotency, key);
+    if (!admit()) {
+        return failed;
+    }
+    result = run();
+    claim.complete(result);
+    return result;
+}
+
+bool SystemCallInterface::admit(int customer_id, int account_id) {
+    if (!customer_limiter.enabled() && !account_limiter.enabled()) {
+        return true;
+    }
+    int64_t now_ns = RateLimiter::now_ns();
+    if (account_id != -1 && !account_limiter.try_acquire(account_id, now_ns)) {
+        errorHandler.handle_error("Request rejected: Rate limit exceeded for Account ID=" + to_string(account_id));
+        return false;
+    }
+    if (customer_id != -1 && !customer_limiter.try_acquire(customer_id, now_ns)) {
+        if (account_id != -1) {
+            account_limiter.refund(account_id);
+        }
+        errorHandler.handle_error("Request rejected: Rate limit exceeded for Customer ID=" + to_string(customer_id));
+        return false;
+    }
+    return true;
+}
+
+bool SystemCallInterface::admit_account(int account_id) {
+    if (!customer_limiter.enabled() && !account_limiter.enabled()) {
+        return true;
+    }
+    // Unknown IDs must not take up buckets; validation logs them
+    int customer_id = accountManager.customer_of(account_id);
+    return customer_id == -1 || admit(customer_id, account_id);
+}
+
+RateLimitMetrics SystemCallInterface::rate_limit_metrics() const {
+    RateLimitMetrics metrics;
+    metrics.customer_rejected = customer_limiter.rejected();
+    metrics.account_rejected = account_limiter.rejected();
+    metrics.overflowed = customer_limiter.overflowed() + account_limiter.overflowed();
+    return metrics;
+}
+
+void SystemCallInterface::notify(const string& event_type, int account_id, int customer_id, const string& payload) {
+    if (!ipcManager) {
+        return;
+    }
+    ipcManager->publish({ IPCManager::account_topic(account_id),
+                          IPCManager::customer_topic(customer_id),
+                          IPCManager::event_topic(event_type) }, payload);
+}
+
+void SystemCallInterface::notify(const string& event_type, int account_id, const string& payload) {
+    if (!ipcManager) {
+        return;
+    }
+    notify(event_type, account_id, accountManager.get_account(account_id).customer_id, payload);
+}
+
+void SystemCallInterface::notify_batch_result(const AccountManager::Operation& op) {
+    if (op.customer_id == -1) {
+        return; // Unknown account; nothing to notify
+    }
+    string amount = to_string(op.amount);
+    switch (op.type) {
+    case AccountManager::Operation::CreateAccount:
+        notify("create_account", op.result_account_id, op.customer_id, "Account created: ID=" + to_string(op.result_account_id) + ", Initial Balance=" + amount);
+        break;
+    case AccountManager::Operation::Deposit:
+        if (op.ok) {
+            notify("deposit", op.account_id, op.customer_id, "Deposit: Account ID=" + to_string(op.account_id) + ", Amount=" + amount);
+        }
+        break;
+    case AccountManager::Operation::Withdraw:
+        notify(op.ok ? "withdraw" : "withdraw_failed", op.account_id, op.customer_id,
+            (op.ok ? "Withdrawal: Account ID=" : "Withdrawal failed: Account ID=") + to_string(op.account_id) + ", Amount=" + amount);
+        break;
+    case AccountManager::Operation::Transfer: {
+        string payload = "Transfer: From Account ID=" + to_string(op.account_id) + ", To Account ID=" + to_string(op.to_account_id) + ", Amount=" + amount;
+        if (op.ok) {
+            notify("transfer_out", op.account_id, op.customer_id, payload);
+            notify("transfer_in", op.to_account_id, payload);
+        }
+        else {
+            notify("transfer_failed", op.account_id, op.customer_id, "Transfer failed: " + payload.substr(strlen("Transfer: ")));
+        }
+        break;
+    }
+    case AccountManager::Operation::CheckBalance:
+        break;
+    }
+}
+
+int SystemCallInterface::create_account(int customer_id, float initial_balance, uint64_t idempotency_key) {
+    return static_cast<int>(run_once(idempotency_key, request_fingerprint(1, customer_id, 0, initial_balance), -1,
+        [&] { return admit(customer_id, -1); }, [&]() -> int64_t {
+        if (!isfinite(initial_balance) || initial_balance < 0) {
+            errorHandler.handle_error("Create account failed: Initial balance must be finite and non-negative.");
+            return -1;
+        }
+        int account_id = accountManager.add_account(customer_id, initial_balance);
+        notify("create_account", account_id, "Account created: ID=" + to_string(account_id) + ", Initial Balance=" + to_string(initial_balance));
+        return account_id;
+    }));
+}
+
+bool SystemCallInterface::deposit(int account_id, float amount, uint64_t idempotency_key) {
+    return run_once(idempotency_key, request_fingerprint(2, account_id, 0, amount), 0,
+        [&] { return admit_account(account_id); }, [&]() -> int64_t {
+        if (!errorHandler.validate_account_id(account_id, accountManager) || !errorHandler.validate_amount(amount)) {
+            return 0;
+        }
+        if (!accountManager.deposit(account_id, amount)) {
+            return 0;
+        }
+        notify("deposit", account_id, "Deposit: Account ID=" + to_string(account_id) + ", Amount=" + to_string(amount));
+        return 1;
+    }) != 0;
+}
+
+bool SystemCallInterface::withdraw(int account_id, float amount, uint64_t idempotency_key) {
+    return run_once(idempotency_key, request_fingerprint(3, account_id, 0, amount), 0,
+        [&] { return admit_account(account_id); }, [&]() -> int64_t {
+        if (!errorHandler.validate_account_id(account_id, accountManager) || !errorHandler.validate_amount(amount)) {
+            return 0;
+        }
+        if (!accountManager.withdraw(account_id, amount)) {
+            notify("withdraw_failed", account_id, "Withdrawal failed: Account ID=" + to_string(account_id) + ", Amount=" + to_string(amount));
+            return 0;
+        }
+        notify("withdraw", account_id, "Withdrawal: Account ID=" + to_string(account_id) + ", Amount=" + to_string(amount));
+        return 1;
+    }) != 0;
+}
+
+bool SystemCallInterface::transfer(int from_account_id, int to_account_id, float amount, uint64_t idempotency_key) {
+    return run_once(idempotency_key, request_fingerprint(5, from_account_id, to_account_id, amount), 0,
+        [&] { return admit_account(from_account_id); }, [&]() -> int64_t {
+        if (from_account_id == to_account_id) {
+            errorHandler.handle_error("Transfer failed: Source and destination accounts are the same.");
+            return 0;
+        }
+        if (!errorHandler.validate_account_id(from_account_id, accountManager) || !errorHandler.validate_account_id(to_account_id, accountManager) ||
+            !errorHandler.validate_amount(amount)) {
+            return 0;
+        }
+        if (!accountManager.transfer(from_account_id, to_account_id, amount)) {
+            notify("transfer_failed", from_account_id, "Transfer failed: From Account ID=" + to_string(from_account_id) + ", To Account ID=" + to_string(to_account_id) + ", Amount=" + to_string(amount));
+            return 0;
+        }
+        string payload = "Transfer: From Account ID=" + to_string(from_account_id) + ", To Account ID=" + to_string(to_account_id) + ", Amount=" + to_string(amount);
+        notify("transfer_out", from_account_id, payload);
+        notify("transfer_in", to_account_id, payload);
+        return 1;
+    }) != 0;
+}
+
+float SystemCallInterface::check_balance(int account_id) {
+    if (!admit_account(account_id) || !errorHandler.validate_account_id(account_id, accountManager)) {
+        return -1.0f;
+    }
+    return accountManager.check_balance(account_id);
+}
+
+void SystemCallInterface::execute_batch(vector<AccountManager::Operation>& ops) {
+    BatchClaims claims{ idempotency, {} };
+    vector<pair<size_t, size_t>> repeats; // Operation and the earlier one in this batch with its key
+    for (size_t i = 0; i < ops.size(); ++i) {
+        auto& op = ops[i];
+        bool keyed = op.idempotency_key != 0 && op.type != AccountManager::Operation::CheckBalance;
+        if (keyed) {
+            // A key the batch already holds would wait on itself
+            uint64_t fingerprint = batch_fingerprint(op);
+            auto first = find_if(claims.held.begin(), claims.held.end(), [&](const auto& claim) { return claim.second == op.idempotency_key; });
+            op.rejected = true;
+            int64_t result = batch_result(op);
+            if (first != claims.held.end()) {
+                if (batch_fingerprint(ops[first->first]) == fingerprint) {
+                    repeats.emplace_back(i, first->first);
+                }
+                else {
+                    errorHandler.handle_error("Request rejected: Idempotency key " + to_string(op.idempotency_key) + " was used for a different request");
+                }
+                continue;
+            }
+            switch (idempotency.begin(op.idempotency_key, fingerprint, result)) {
+            case IdempotencyTable::Claim::Duplicate:
+                replay_result(op, result);
+                continue;
+            case IdempotencyTable::Claim::Mismatch:
+                errorHandler.handle_error("Request rejected: Idempotency key " + to_string(op.idempotency_key) + " was used for a different request");
+                continue;
+            case IdempotencyTable::Claim::Busy:
+                errorHandler.handle_error("Request rejected: Idempotency key " + to_string(op.idempotency_key) + " is still in progress");
+                continue;
+            case IdempotencyTable::Claim::New:
+                op.rejected = false;
+                break;
+            }
+        }
+        switch (op.type) {
+        case AccountManager::Operation::CreateAccount:
+            if (!isfinite(op.amount) || op.amount < 0) {
+                errorHandler.handle_error("Create account failed: Initial balance must be finite and non-negative.");
+                op.rejected = true;
+            }
+            break;
+        case AccountManager::Operation::Transfer:
+            if (op.account_id == op.to_account_id) {
+                errorHandler.handle_error("Transfer failed: Source and destination accounts are the same.");
+                op.rejected = true;
+                break;
+            }
+            op.rejected = !errorHandler.validate_amount(op.amount);
+            break;
+        case AccountManager::Operation::Deposit:
+        case AccountManager::Operation::Withdraw:
+            op.rejected = !errorHandler.validate_amount(op.amount);
+            break;
+        case AccountManager::Operation::CheckBalance:
+            break;
+        }
+        if (!op.rejected && !(op.type == AccountManager::Operation::CreateAccount ? admit(op.account_id, -1) : admit_account(op.account_id))) {
+            // Not recorded: a retry once the limits allow should run
+            op.rejected = true;
+            if (keyed) {
+                idempotency.abandon(op.idempotency_key);
+            }
+            continue;
+        }
+        if (keyed) {
+            // Failed validation is recorded like any other result
+            claims.held.emplace_back(i, op.idempotency_key);
+        }
+    }
+    accountManager.apply_batch(ops);
+    for (const auto& claim : claims.held) {
+        idempotency.complete(claim.second, batch_result(ops[claim.first]));
+    }
+    claims.held.clear();
+    for (const auto& repeat : repeats) {
+        replay_result(ops[repeat.first], batch_result(ops[repeat.second]));
+    }
+    if (ipcManager) {
+        for (const auto& op : ops) {
+            if (!op.rejected) {
+                notify_batch_result(op);
+            }
+        }
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "account_manager.h"
+#include "error_handler.h"
+#include "idempotency_table.h"
+#include "ipc_manager.h"
+#include "rate_limiter.h"
+
+// System Call Interface Module
+// Mutating calls take an optional idempotency key (0 for none): a retry
+// with the key of an earlier call returns that call's result without
+// running again, for as long as IdempotencyPolicy::ttl.
+// Calls on an account are charged to the account and its customer, account
+// creation to the customer; a call over either RateLimitPolicy rate fails
+// and is logged before it does any work. Retries answered from the
+// idempotency table are not charged.
+class SystemCallInterface {
+private:
+    AccountManager& accountManager;
+    ErrorHandler& errorHandler;
+    IPCManager* ipcManager; // Optional: transaction events are published when set
+    IdempotencyTable idempotency;
+    RateLimiter customer_limiter;
+    RateLimiter account_limiter;
+
+    // Take a token for the call from the customer and the account (-1 for
+    // none); false, and logged, if either is over its rate
+    bool admit(int customer_id, int account_id);
+
+    // admit() for a call on an existing account, charged to its owner too.
+    // Unknown accounts pass, to be rejected by validation.
+    bool admit_account(int account_id);
+
+    // Run the call unless `key` was seen before. Only a call that will run
+    // is charged to the rate limits by `admit`; `failed` is the result when
+    // it is turned away, the key was used for a different call, or the call
+    // that first used it is still running after the wait timeout.
+    template <typename Admit, typename Run>
+    int64_t run_once(uint64_t key, uint64_t fingerprint, int64_t failed, Admit admit, Run run);
+
+    // Publish a transaction event on the account, customer and event-type topics
+    void notify(const std::string& event_type, int account_id, int customer_id, const std::string& payload);
+
+    void notify(const std::string& event_type, int account_id, const std::string& payload);
+
+    // Publish the event for one completed batch operation
+    void notify_batch_result(const AccountManager::Operation& op);
+
+public:
+    SystemCallInterface(AccountManager& am, ErrorHandler& eh, IPCManager* ipc = nullptr,
+                        const IdempotencyPolicy& idempotency_policy = {}, const RateLimitPolicy& rate_limit_policy = {})
+        : accountManager(am), errorHandler(eh), ipcManager(ipc), idempotency(idempotency_policy),
+          customer_limiter(rate_limit_policy.customer_rate, rate_limit_policy.customer_burst, rate_limit_policy.max_tracked),
+          account_limiter(rate_limit_policy.account_rate, rate_limit_policy.account_burst, rate_limit_policy.max_tracked) {}
+
+    int create_account(int customer_id, float initial_balance, uint64_t idempotency_key = 0);
+
+    bool deposit(int account_id, float amount, uint64_t idempotency_key = 0);
+
+    bool withdraw(int account_id, float amount, uint64_t idempotency_key = 0);
+
+    bool transfer(int from_account_id, int to_account_id, float amount, uint64_t idempotency_key = 0);
+
+    // Retries answered with an earlier result
+    uint64_t duplicate_requests() const { return idempotency.duplicates(); }
+
+    RateLimitMetrics rate_limit_metrics() const;
+
+    float check_balance(int account_id);
+
+    // Batch path for pipelined requests: amounts and rate limits are checked
+    // here, then the whole batch is applied with one account-lock acquisition. Unknown
+    // accounts are rejected (and logged) by AccountManager instead of being
+    // looked up once per operation. Results are written back into `ops`.
+    // Operations with an idempotency key go through the same table as the
+    // single calls: a repeat is answered with the recorded result and does
+    // not run or notify again.
+    void execute_batch(std::vector<AccountManager::Operation>& ops);
+};
@@ -0,0 +1,154 @@
+#include "transaction_client.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+bool TransactionClient::write_all(int fd, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = send(fd, bytes, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        bytes += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool TransactionClient::round_trip(WireOp op, int arg1, int arg2, float amount, uint64_t idempotency_key, WireResponse& response) {
+    uint32_t request_id = submit(op, arg1, arg2, amount, idempotency_key);
+    return flush() && receive(response) && response.request_id == request_id;
+}
+
+TransactionClient::~TransactionClient() {
+    disconnect();
+}
+
+bool TransactionClient::connect_tcp(uint16_t port) {
+    disconnect();
+    fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        disconnect();
+        return false;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return true;
+}
+
+bool TransactionClient::connect_unix(const string& path) {
+    disconnect();
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) {
+        return false;
+    }
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        disconnect();
+        return false;
+    }
+    return true;
+}
+
+void TransactionClient::disconnect() {
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+    send_buffer.clear();
+    recv_buffer.clear();
+    recv_offset = 0;
+}
+
+uint32_t TransactionClient::submit(WireOp op, int arg1, int arg2, float amount, uint64_t idempotency_key) {
+    WireRequest request{};
+    request.op = static_cast<uint8_t>(op);
+    request.flags = idempotency_key != 0 ? WIRE_FLAG_KEYED : 0;
+    request.request_id = next_request_id++;
+    request.arg1 = arg1;
+    request.arg2 = arg2;
+    request.amount = amount;
+    const char* bytes = reinterpret_cast<const char*>(&request);
+    send_buffer.insert(send_buffer.end(), bytes, bytes + sizeof(request));
+    if (idempotency_key != 0) {
+        const char* key = reinterpret_cast<const char*>(&idempotency_key);
+        send_buffer.insert(send_buffer.end(), key, key + sizeof(idempotency_key));
+    }
+    return request.request_id;
+}
+
+bool TransactionClient::flush() {
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = write_all(fd, send_buffer.data(), send_buffer.size());
+    send_buffer.clear();
+    return ok;
+}
+
+bool TransactionClient::receive(WireResponse& response) {
+    while (recv_buffer.size() - recv_offset < sizeof(WireResponse)) {
+        if (fd < 0) {
+            return false;
+        }
+        recv_buffer.erase(recv_buffer.begin(), recv_buffer.begin() + recv_offset);
+        recv_offset = 0;
+        size_t used = recv_buffer.size();
+        recv_buffer.resize(used + 64 * 1024);
+        ssize_t n = recv(fd, recv_buffer.data() + used, 64 * 1024, 0);
+        recv_buffer.resize(used + max<ssize_t>(n, 0));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+    }
+    memcpy(&response, recv_buffer.data() + recv_offset, sizeof(response));
+    recv_offset += sizeof(response);
+    return true;
+}
+
+int TransactionClient::create_account(int customer_id, float initial_balance, uint64_t idempotency_key) {
+    WireResponse response;
+    return round_trip(WireOp::CreateAccount, customer_id, 0, initial_balance, idempotency_key, response) ? response.account_id : -1;
+}
+
+bool TransactionClient::deposit(int account_id, float amount, uint64_t idempotency_key) {
+    WireResponse response;
+    return round_trip(WireOp::Deposit, account_id, 0, amount, idempotency_key, response) && response.status == static_cast<uint8_t>(WireStatus::Ok);
+}
+
+bool TransactionClient::withdraw(int account_id, float amount, uint64_t idempotency_key) {
+    WireResponse response;
+    return round_trip(WireOp::Withdraw, account_id, 0, amount, idempotency_key, response) && response.status == static_cast<uint8_t>(WireStatus::Ok);
+}
+
+bool TransactionClient::transfer(int from_account_id, int to_account_id, float amount, uint64_t idempotency_key) {
+    WireResponse response;
+    return round_trip(WireOp::Transfer, from_account_id, to_account_id, amount, idempotency_key, response) && response.status == static_cast<uint8_t>(WireStatus::Ok);
+}
+
+float TransactionClient::check_balance(int account_id) {
+    WireResponse response;
+    return round_trip(WireOp::CheckBalance, account_id, 0, 0.0f, 0, response) ? response.balance : -1.0f;
+}
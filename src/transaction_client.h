@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "wire_protocol.h"
+
+// TransactionClient class: blocking client for the transaction server.
+// The create_account/deposit/... methods mirror SystemCallInterface,
+// including its failure values and optional idempotency keys, and do one
+// round trip each; resend with the same key after a lost response. For pipelining,
+// submit() many requests, flush() them in one write, then receive() the
+// responses in order.
+class TransactionClient {
+private:
+    int fd = -1;
+    uint32_t next_request_id = 1;
+    std::vector<char> send_buffer; // Submitted requests not yet written
+    std::vector<char> recv_buffer; // Bytes read ahead of the next response
+    size_t recv_offset = 0;
+
+    static bool write_all(int fd, const void* data, size_t size);
+
+    bool round_trip(WireOp op, int arg1, int arg2, float amount, uint64_t idempotency_key, WireResponse& response);
+
+public:
+    TransactionClient() = default;
+    TransactionClient(const TransactionClient&) = delete;
+    TransactionClient& operator=(const TransactionClient&) = delete;
+
+    ~TransactionClient();
+
+    bool connect_tcp(uint16_t port);
+
+    bool connect_unix(const std::string& path);
+
+    void disconnect();
+
+    // Queue a request without sending it; returns its request ID. A nonzero
+    // key is sent in a keyed frame.
+    uint32_t submit(WireOp op, int arg1, int arg2, float amount, uint64_t idempotency_key = 0);
+
+    // Write every submitted request in one go
+    bool flush();
+
+    // Wait for the next response. Reads are batched, so a burst of
+    // coalesced responses costs one recv().
+    bool receive(WireResponse& response);
+
+    int create_account(int customer_id, float initial_balance, uint64_t idempotency_key = 0);
+
+    bool deposit(int account_id, float amount, uint64_t idempotency_key = 0);
+
+    bool withdraw(int account_id, float amount, uint64_t idempotency_key = 0);
+
+    bool transfer(int from_account_id, int to_account_id, float amount, uint64_t idempotency_key = 0);
+
+    float check_balance(int account_id);
+};
@@ -0,0 +1,289 @@
+#include "transaction_log_index.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+
+namespace {
+
+const char INDEX_MAGIC[8] = { 'B', 'A', 'N', 'K', 'I', 'D', 'X', '2' };
+
+// Layout: magic, entry count, block count, first account of each block, entries
+uint64_t entries_start(uint64_t blocks) {
+    return sizeof(INDEX_MAGIC) + 2 * sizeof(uint64_t) + blocks * sizeof(int32_t);
+}
+
+bool read_directory(const string& path, TransactionLogIndex::Directory& directory) {
+    ifstream in(path, ios::binary);
+    char magic[8];
+    uint64_t blocks = 0;
+    if (!in.read(magic, sizeof(magic)) || !equal(magic, magic + 8, INDEX_MAGIC)
+        || !in.read(reinterpret_cast<char*>(&directory.entries), sizeof(uint64_t))
+        || !in.read(reinterpret_cast<char*>(&blocks), sizeof(uint64_t))) {
+        return false;
+    }
+    directory.block_first_account.resize(blocks);
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(directory.block_first_account.data()), static_cast<streamsize>(blocks * sizeof(int32_t))));
+}
+
+TransactionLogIndex::Directory write_index_file(const string& path, const vector<TransactionLogIndex::Entry>& entries) {
+    TransactionLogIndex::Directory directory;
+    directory.entries = entries.size();
+    for (size_t i = 0; i < entries.size(); i += TransactionLogIndex::BLOCK_ENTRIES) {
+        directory.block_first_account.push_back(entries[i].account_id);
+    }
+
+    string tmp_path = path + ".tmp";
+    {
+        ofstream out(tmp_path, ios::binary | ios::trunc);
+        uint64_t blocks = directory.block_first_account.size();
+        out.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+        out.write(reinterpret_cast<const char*>(&directory.entries), sizeof(uint64_t));
+        out.write(reinterpret_cast<const char*>(&blocks), sizeof(uint64_t));
+        out.write(reinterpret_cast<const char*>(directory.block_first_account.data()), static_cast<streamsize>(blocks * sizeof(int32_t)));
+        out.write(reinterpret_cast<const char*>(entries.data()), static_cast<streamsize>(entries.size() * sizeof(TransactionLogIndex::Entry)));
+    }
+    rename(tmp_path.c_str(), path.c_str());
+    return directory;
+}
+
+// Entries for one account, read from the only blocks that can hold it
+vector<TransactionLogIndex::Entry> read_account_entries(const string& path, const TransactionLogIndex::Directory& directory, int32_t account_id) {
+    vector<TransactionLogIndex::Entry> result;
+    const auto& firsts = directory.block_first_account;
+    // The account may start inside the last block whose first account is smaller
+    size_t first_block = static_cast<size_t>(lower_bound(firsts.begin(), firsts.end(), account_id) - firsts.begin());
+    first_block = first_block == 0 ? 0 : first_block - 1;
+    size_t end_block = static_cast<size_t>(upper_bound(firsts.begin(), firsts.end(), account_id) - firsts.begin());
+    if (end_block <= first_block) {
+        return result;
+    }
+
+    uint64_t begin = first_block * TransactionLogIndex::BLOCK_ENTRIES;
+    uint64_t end = min<uint64_t>(directory.entries, end_block * TransactionLogIndex::BLOCK_ENTRIES);
+    vector<TransactionLogIndex::Entry> block(static_cast<size_t>(end - begin));
+    ifstream in(path, ios::binary);
+    in.seekg(static_cast<streamoff>(entries_start(firsts.size()) + begin * sizeof(TransactionLogIndex::Entry)));
+    if (!in.read(reinterpret_cast<char*>(block.data()), static_cast<streamsize>(block.size() * sizeof(TransactionLogIndex::Entry)))) {
+        return result;
+    }
+    for (const auto& entry : block) {
+        if (entry.account_id == account_id) {
+            result.push_back(entry);
+        }
+    }
+    return result;
+}
+
+bool entry_less(const TransactionLogIndex::Entry& a, const TransactionLogIndex::Entry& b) {
+    return a.account_id != b.account_id ? a.account_id < b.account_id : a.offset < b.offset;
+}
+
+bool mentions(string_view record, int32_t account_id) {
+    int32_t ids[TransactionLogIndex::MAX_ACCOUNTS_PER_RECORD];
+    size_t count = TransactionLogIndex::parse_account_ids(record, ids);
+    return find(ids, ids + count, account_id) != ids + count;
+}
+
+// Read the account's records starting at the given (ascending) offsets of
+// one segment
+void read_records(const string& raw_path, const vector<uint64_t>& offsets, int32_t account_id, vector<string>& out) {
+    SegmentRecordReader reader(raw_path);
+    string line;
+    for (uint64_t offset : offsets) {
+        if (reader.read_at(offset, line) && mentions(line, account_id)) {
+            out.push_back(line);
+        }
+    }
+}
+
+}
+
+TransactionLogIndex::TransactionLogIndex(SegmentedLog& log)
+    : log(log), segments(log.closed_segments()), active_segment_id(log.active_segment_id()) {
+    log.set_rotation_listener([this](const LogSegment& segment) { seal(segment); });
+
+    LogReader reader(vector<string>{ log.path() });
+    string line;
+    lock_guard<mutex> lock(mtx);
+    while (reader.next(line)) {
+        add_locked(line, reader.record_offset(), parse_record_time(line));
+    }
+}
+
+void TransactionLogIndex::add(string_view record, uint64_t offset, int64_t time) {
+    lock_guard<mutex> lock(mtx);
+    add_locked(record, offset, time);
+}
+
+void TransactionLogIndex::add_locked(string_view record, uint64_t offset, int64_t time) {
+    int32_t ids[MAX_ACCOUNTS_PER_RECORD];
+    size_t count = parse_account_ids(record, ids);
+    for (size_t i = 0; i < count; ++i) {
+        auto& postings = active_postings[ids[i]];
+        // Transfers to the same account mention it twice
+        if (postings.empty() || postings.back().offset != offset) {
+            postings.push_back({ offset, time });
+        }
+    }
+}
+
+void TransactionLogIndex::seal(const LogSegment& segment) {
+    // Queries wait out the (rare) index write, so they find the postings
+    // either active or in the segment's index, never in neither
+    lock_guard<mutex> lock(mtx);
+    vector<Entry> entries;
+    for (const auto& [account_id, postings] : active_postings) {
+        for (const auto& posting : postings) {
+            entries.push_back({ account_id, 0, posting.offset, posting.time });
+        }
+    }
+    active_postings.clear();
+    sort(entries.begin(), entries.end(), entry_less);
+    directories[segment.id] = make_shared<Directory>(write_index_file(index_path_for(log.path(), segment.id), entries));
+    segments.push_back(segment);
+    active_segment_id = segment.id + 1;
+}
+
+shared_ptr<const TransactionLogIndex::Directory> TransactionLogIndex::load_directory(const LogSegment& segment) {
+    {
+        lock_guard<mutex> lock(mtx);
+        auto it = directories.find(segment.id);
+        if (it != directories.end()) {
+            return it->second;
+        }
+    }
+
+    auto directory = make_shared<Directory>();
+    string path = index_path_for(log.path(), segment.id);
+    if (!read_directory(path, *directory)) {
+        // Segment from before indexing existed: build its index once
+        vector<Entry> entries;
+        LogReader reader(vector<string>{ segment.path });
+        string line;
+        while (reader.next(line)) {
+            int32_t ids[MAX_ACCOUNTS_PER_RECORD];
+            size_t count = parse_account_ids(line, ids);
+            int64_t time = parse_record_time(line);
+            for (size_t i = 0; i < count; ++i) {
+                entries.push_back({ ids[i], 0, reader.record_offset(), time });
+            }
+        }
+        sort(entries.begin(), entries.end(), entry_less);
+        entries.erase(unique(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            return a.account_id == b.account_id && a.offset == b.offset;
+        }), entries.end());
+        *directory = write_index_file(path, entries);
+    }
+
+    lock_guard<mutex> lock(mtx);
+    return directories.emplace(segment.id, move(directory)).first->second;
+}
+
+vector<string> TransactionLogIndex::history(int account_id, int64_t from, int64_t to) {
+    vector<string> result;
+    vector<uint64_t> offsets;
+    vector<uint64_t> active_offsets;
+    vector<LogSegment> closed;
+    uint64_t active_id;
+    {
+        lock_guard<mutex> lock(mtx);
+        closed = segments;
+        active_id = active_segment_id;
+        auto it = active_postings.find(account_id);
+        if (it != active_postings.end()) {
+            for (const auto& posting : it->second) {
+                if (posting.time >= from && posting.time <= to) {
+                    active_offsets.push_back(posting.offset);
+                }
+            }
+        }
+    }
+
+    for (const auto& segment : closed) {
+        // Segment-level time range prunes most of the log before any index is read
+        if (segment.closed_at < from || segment.opened_at > to) {
+            continue;
+        }
+        auto directory = load_directory(segment);
+        offsets.clear();
+        for (const auto& entry : read_account_entries(index_path_for(log.path(), segment.id), *directory, account_id)) {
+            if (entry.time >= from && entry.time <= to) {
+                offsets.push_back(entry.offset);
+            }
+        }
+        if (!offsets.empty()) {
+            string raw_path = segment.compressed() ? segment.path.substr(0, segment.path.size() - 3) : segment.path;
+            read_records(raw_path, offsets, account_id, result);
+        }
+    }
+
+    if (!active_offsets.empty()) {
+        size_t before = result.size();
+        read_records(log.path(), active_offsets, account_id, result);
+        bool rotated;
+        {
+            lock_guard<mutex> lock(mtx);
+            rotated = active_segment_id != active_id;
+        }
+        if (rotated) {
+            // The file may have been renamed before we opened it: read the
+            // postings from the segment they were sealed into instead
+            result.resize(before);
+            read_records(SegmentedLog::segment_path(log.path(), active_id), active_offsets, account_id, result);
+        }
+    }
+    return result;
+}
+
+string TransactionLogIndex::index_path_for(const string& active_path, uint64_t segment_id) {
+    return SegmentedLog::segment_path(active_path, segment_id) + ".idx";
+}
+
+size_t TransactionLogIndex::parse_account_ids(string_view record, int32_t (&ids)[MAX_ACCOUNTS_PER_RECORD]) {
+    size_t count = 0;
+    size_t pos = 0;
+    while (count < MAX_ACCOUNTS_PER_RECORD && (pos = record.find("ID=", pos)) != string_view::npos) {
+        pos += 3;
+        // Stop accumulating past INT32_MAX; such a number is not an account id
+        int64_t value = 0;
+        size_t digits = 0;
+        while (pos < record.size() && record[pos] >= '0' && record[pos] <= '9') {
+            if (value <= INT32_MAX) {
+                value = value * 10 + (record[pos] - '0');
+            }
+            ++pos;
+            ++digits;
+        }
+        if (digits != 0 && value <= INT32_MAX) {
+            ids[count++] = static_cast<int32_t>(value);
+        }
+    }
+    return count;
+}
+
+int64_t TransactionLogIndex::parse_record_time(string_view record) {
+    // "[Www Mmm dd hh:mm:ss.uuuuuu yyyy] "
+    if (record.size() < 33 || record[0] != '[') {
+        return -1;
+    }
+    tm fields{};
+    istringstream in(string(record.substr(1, 19)));
+    in >> get_time(&fields, "%a %b %d %H:%M:%S");
+    size_t space = record.find(' ', 20);
+    if (in.fail() || space == string_view::npos) {
+        return -1;
+    }
+    int year = 0;
+    for (size_t pos = space + 1; pos < record.size() && record[pos] >= '0' && record[pos] <= '9'; ++pos) {
+        year = year * 10 + (record[pos] - '0');
+    }
+    fields.tm_year = year - 1900;
+    fields.tm_isdst = -1;
+    return static_cast<int64_t>(mktime(&fields));
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "log_segments.h"
+
+// TransactionLogIndex class for per-account history over a segmented log.
+// The log writer feeds every record through add(); the accounts it mentions
+// ("ID=<n>") are indexed by offset within the active segment. When a segment
+// is closed its postings are sorted by account and written next to it as
+// <segment>.idx, so a history query only opens the segments whose time range
+// overlaps the query, reads the index blocks for the account, and seeks
+// straight to the matching records. The closed segments and the active
+// postings change together under one lock, so a query racing a rotation sees
+// each record in exactly one of them.
+class TransactionLogIndex {
+public:
+    // On-disk posting; sorted by (account_id, offset) within a segment
+    struct Entry {
+        int32_t account_id;
+        uint32_t reserved;
+        uint64_t offset;
+        int64_t time; // Unix seconds the record was written
+    };
+
+    static constexpr size_t MAX_ACCOUNTS_PER_RECORD = 4;
+
+    // Sparse directory over a segment's sorted entries: the first account of
+    // every BLOCK_ENTRIES-th entry. Only this is kept in memory; a query reads
+    // just the blocks that can hold its account.
+    static constexpr size_t BLOCK_ENTRIES = 256;
+
+    struct Directory {
+        std::vector<int32_t> block_first_account;
+        uint64_t entries = 0;
+    };
+
+private:
+    struct Posting {
+        uint64_t offset;
+        int64_t time;
+    };
+
+    SegmentedLog& log;
+    std::mutex mtx;
+    std::unordered_map<int32_t, std::vector<Posting>> active_postings;
+    std::vector<LogSegment> segments; // Closed segments as of the active postings
+    uint64_t active_segment_id;       // Id the active postings' segment gets when closed
+    std::map<uint64_t, std::shared_ptr<const Directory>> directories; // Loaded .idx directories by segment id
+
+    void seal(const LogSegment& segment);
+    std::shared_ptr<const Directory> load_directory(const LogSegment& segment);
+    void add_locked(std::string_view record, uint64_t offset, int64_t time);
+
+public:
+    // Registers itself as the log's rotation listener and indexes whatever
+    // the active file already holds from an earlier run
+    explicit TransactionLogIndex(SegmentedLog& log);
+
+    // Index a record about to be appended at `offset` of the active segment.
+    // Must be called on the appending thread, before SegmentedLog::append.
+    void add(std::string_view record, uint64_t offset, int64_t time);
+
+    // Records mentioning the account written in [from, to] (Unix seconds),
+    // oldest first. Records still buffered by the writer are not visible,
+    // and a record read back is used only if it is whole and mentions the
+    // account.
+    std::vector<std::string> history(int account_id, int64_t from, int64_t to);
+
+    static std::string index_path_for(const std::string& active_path, uint64_t segment_id);
+
+    // Account ids referenced by a record; returns how many were found
+    static size_t parse_account_ids(std::string_view record, int32_t (&ids)[MAX_ACCOUNTS_PER_RECORD]);
+
+    // Timestamp of a "[Www Mmm dd hh:mm:ss.uuuuuu yyyy] ..." record, or -1
+    static int64_t parse_record_time(std::string_view record);
+};
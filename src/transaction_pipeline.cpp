@@ -0,0 +1,23 @@
+#include "transaction_pipeline.h"
+
+using namespace std;
+
+Task<int> TransactionPipeline::create_account(int customer_id, float initial_balance) {
+    co_return sysCallInterface.create_account(customer_id, initial_balance);
+}
+
+Task<bool> TransactionPipeline::deposit(int account_id, float amount) {
+    co_return sysCallInterface.deposit(account_id, amount);
+}
+
+Task<bool> TransactionPipeline::withdraw(int account_id, float amount) {
+    co_return sysCallInterface.withdraw(account_id, amount);
+}
+
+Task<bool> TransactionPipeline::transfer(int from_account_id, int to_account_id, float amount) {
+    co_return sysCallInterface.transfer(from_account_id, to_account_id, amount);
+}
+
+Task<float> TransactionPipeline::check_balance(int account_id) {
+    co_return sysCallInterface.check_balance(account_id);
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <coroutine>
+#include <utility>
+
+#include "executor.h"
+#include "ipc_manager.h"
+#include "logger.h"
+#include "system_call_interface.h"
+#include "task.h"
+
+// TransactionPipeline class: coroutine front end for the system call interface.
+// Account operations are short critical sections and run inline on the
+// executor thread; IPC receives and log flushes suspend the coroutine instead
+// of blocking the thread.
+class TransactionPipeline {
+private:
+    SystemCallInterface& sysCallInterface;
+    IPCManager& ipcManager;
+    Logger& logger;
+    Executor& executor;    // Runs transaction coroutines
+    Executor& io_executor; // Runs blocking file I/O off the transaction threads
+
+public:
+    TransactionPipeline(SystemCallInterface& sci, IPCManager& ipc, Logger& logger, Executor& executor, Executor& io_executor)
+        : sysCallInterface(sci), ipcManager(ipc), logger(logger), executor(executor), io_executor(io_executor) {}
+
+    Task<int> create_account(int customer_id, float initial_balance);
+
+    Task<bool> deposit(int account_id, float amount);
+
+    Task<bool> withdraw(int account_id, float amount);
+
+    Task<bool> transfer(int from_account_id, int to_account_id, float amount);
+
+    Task<float> check_balance(int account_id);
+
+    // Suspend until the subscriber's next message arrives (nullptr if unsubscribed)
+    auto receive(int subscriber_id) {
+        struct ReceiveAwaiter {
+            IPCManager& ipc;
+            Executor& executor;
+            int subscriber_id;
+            IPCManager::MessagePtr message;
+
+            bool await_ready() const noexcept { return false; }
+
+            void await_suspend(std::coroutine_handle<> handle) {
+                // The handler may run before this returns; it must not touch
+                // the awaiter after rescheduling the coroutine
+                ipc.receive_async(subscriber_id, [this, handle](IPCManager::MessagePtr received) {
+                    message = std::move(received);
+                    executor.schedule(handle);
+                });
+            }
+
+            IPCManager::MessagePtr await_resume() { return std::move(message); }
+        };
+        return ReceiveAwaiter{ ipcManager, executor, subscriber_id, nullptr };
+    }
+
+    // Suspend while the log files are flushed on the I/O executor
+    auto flush_log() {
+        struct FlushAwaiter {
+            Logger& logger;
+            Executor& executor;
+            Executor& io_executor;
+
+            bool await_ready() const noexcept { return false; }
+
+            void await_suspend(std::coroutine_handle<> handle) {
+                Logger& log = logger;
+                Executor& resume_on = executor;
+                io_executor.post([&log, &resume_on, handle] {
+                    log.flush();
+                    resume_on.schedule(handle);
+                });
+            }
+
+            void await_resume() const noexcept {}
+        };
+        return FlushAwaiter{ logger, executor, io_executor };
+    }
+};
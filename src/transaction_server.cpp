@@ -0,0 +1,336 @@
+#include "transaction_server.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+int TransactionServer::create_tcp_listener(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(fd, SOMAXCONN) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool TransactionServer::watch(int epoll_fd, int fd, uint32_t events) {
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = fd;
+    return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+void TransactionServer::accept_connections(EventLoop& loop, int listen_fd, unordered_map<int, Connection>& connections) {
+    while (true) {
+        int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                errorHandler.handle_error("Transaction server accept failed: " + string(strerror(errno)));
+            }
+            return;
+        }
+        if (listen_fd != unix_listen_fd) {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+        if (!watch(loop.epoll_fd, fd, EPOLLIN | EPOLLRDHUP)) {
+            close(fd);
+            continue;
+        }
+        connections.emplace(fd, Connection{});
+    }
+}
+
+void TransactionServer::process_requests(Connection& connection) {
+    vector<WireRequest> requests;
+    vector<AccountManager::Operation> ops;
+    vector<int> op_index; // Per request: index into `ops`, or -1 for a bad request
+    size_t offset = 0;
+    bool complete = true; // Whether a whole frame may still follow `offset`
+    while (complete && connection.in.size() - offset >= sizeof(WireRequest)) {
+        requests.clear();
+        ops.clear();
+        op_index.clear();
+        while (requests.size() < MAX_BATCH && connection.in.size() - offset >= sizeof(WireRequest)) {
+            WireRequest request;
+            memcpy(&request, connection.in.data() + offset, sizeof(request));
+            if (connection.in.size() - offset < wire_request_size(request)) {
+                complete = false; // The key has not arrived yet
+                break;
+            }
+            uint64_t key = 0;
+            if (request.flags & WIRE_FLAG_KEYED) {
+                memcpy(&key, connection.in.data() + offset + sizeof(request), sizeof(key));
+            }
+            offset += wire_request_size(request);
+            AccountManager::Operation op{};
+            if (decode_request(request, key, op)) {
+                op_index.push_back(static_cast<int>(ops.size()));
+                ops.push_back(op);
+            }
+            else {
+                op_index.push_back(-1);
+            }
+            requests.push_back(request);
+        }
+        if (requests.empty()) {
+            break;
+        }
+        sysCallInterface.execute_batch(ops);
+
+        size_t used = connection.out.size();
+        connection.out.resize(used + requests.size() * sizeof(WireResponse));
+        for (size_t i = 0; i < requests.size(); ++i) {
+            WireResponse response = encode_response(requests[i], op_index[i] >= 0 ? &ops[op_index[i]] : nullptr);
+            memcpy(connection.out.data() + used + i * sizeof(WireResponse), &response, sizeof(response));
+        }
+    }
+    connection.in.erase(connection.in.begin(), connection.in.begin() + offset);
+}
+
+bool TransactionServer::read_requests(int fd, Connection& connection) {
+    bool open = true;
+    size_t read = 0;
+    // Level-triggered: whatever is left over wakes the loop again
+    while (read < MAX_READ) {
+        size_t used = connection.in.size();
+        connection.in.resize(used + READ_CHUNK);
+        ssize_t n = recv(fd, connection.in.data() + used, READ_CHUNK, 0);
+        connection.in.resize(used + max<ssize_t>(n, 0));
+        if (n > 0) {
+            read += static_cast<size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            open = false;
+        }
+        break;
+    }
+    process_requests(connection);
+    return open;
+}
+
+bool TransactionServer::flush_responses(EventLoop& loop, int fd, Connection& connection) {
+    while (connection.out_offset < connection.out.size()) {
+        ssize_t n = send(fd, connection.out.data() + connection.out_offset,
+            connection.out.size() - connection.out_offset, MSG_NOSIGNAL);
+        if (n > 0) {
+            connection.out_offset += n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        return false;
+    }
+    size_t backlog = connection.out.size() - connection.out_offset;
+    if (backlog == 0) {
+        connection.out.clear();
+        connection.out_offset = 0;
+    }
+    else if (connection.out_offset > backlog) {
+        // Drop what was sent so a slow reader's buffer does not keep growing
+        connection.out.erase(connection.out.begin(), connection.out.begin() + connection.out_offset);
+        connection.out_offset = 0;
+    }
+    bool pending = backlog != 0;
+    bool reading = !connection.draining && backlog <= (connection.reading ? OUT_HIGH_WATER : OUT_LOW_WATER);
+    if (pending != connection.want_write || reading != connection.reading) {
+        epoll_event event{};
+        // Without EPOLLRDHUP too, a half-closed peer would wake a paused loop
+        event.events = reading ? EPOLLIN | EPOLLRDHUP : 0;
+        if (pending) {
+            event.events |= EPOLLOUT;
+        }
+        event.data.fd = fd;
+        epoll_ctl(loop.epoll_fd, EPOLL_CTL_MOD, fd, &event);
+        connection.want_write = pending;
+        connection.reading = reading;
+    }
+    return true;
+}
+
+void TransactionServer::run_loop(EventLoop& loop) {
+    unordered_map<int, Connection> connections;
+    epoll_event events[MAX_EVENTS];
+    while (running) {
+        int n = epoll_wait(loop.epoll_fd, events, MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            errorHandler.handle_error("Transaction server epoll_wait failed: " + string(strerror(errno)));
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == loop.wake_fd) {
+                continue; // stop() flipped `running`; the loop condition handles it
+            }
+            if (fd == loop.tcp_listen_fd || fd == unix_listen_fd) {
+                accept_connections(loop, fd, connections);
+                continue;
+            }
+            auto it = connections.find(fd);
+            if (it == connections.end()) {
+                continue;
+            }
+            Connection& connection = it->second;
+            if (connection.reading && (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP))) {
+                connection.draining = !read_requests(fd, connection);
+            }
+            // Responses for everything read so far go out even if the peer
+            // half-closed; a draining connection waits on EPOLLOUT until then
+            bool writable = flush_responses(loop, fd, connection);
+            bool drained = connection.draining && connection.out.empty();
+            if (!writable || drained || (events[i].events & EPOLLERR)) {
+                close(fd);
+                connections.erase(it);
+            }
+        }
+    }
+    for (auto& entry : connections) {
+        close(entry.first);
+    }
+}
+
+TransactionServer::~TransactionServer() {
+    stop();
+}
+
+bool TransactionServer::listen_tcp(uint16_t port) {
+    first_tcp_fd = create_tcp_listener(port);
+    if (first_tcp_fd < 0) {
+        errorHandler.handle_error("Transaction server failed to listen on TCP port " + to_string(port) + ": " + strerror(errno));
+        return false;
+    }
+    sockaddr_in addr{};
+    socklen_t len = sizeof(addr);
+    getsockname(first_tcp_fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    tcp_port = ntohs(addr.sin_port);
+    return true;
+}
+
+bool TransactionServer::listen_unix(const string& path) {
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) {
+        errorHandler.handle_error("Transaction server Unix socket path too long: " + path);
+        return false;
+    }
+    unix_listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    unlink(path.c_str());
+    if (unix_listen_fd < 0 || bind(unix_listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        listen(unix_listen_fd, SOMAXCONN) < 0) {
+        errorHandler.handle_error("Transaction server failed to listen on " + path + ": " + strerror(errno));
+        if (unix_listen_fd >= 0) {
+            close(unix_listen_fd);
+            unix_listen_fd = -1;
+        }
+        return false;
+    }
+    unix_path = path;
+    return true;
+}
+
+uint16_t TransactionServer::port() const {
+    return tcp_port;
+}
+
+bool TransactionServer::start(size_t num_loops) {
+    if (first_tcp_fd < 0 && unix_listen_fd < 0) {
+        errorHandler.handle_error("Transaction server has no listener configured.");
+        return false;
+    }
+    size_t count = max<size_t>(num_loops, 1);
+    // Every loop needs its own TCP listener, or the kernel would keep
+    // handing connections only to the loops that have one
+    vector<int> tcp_fds;
+    if (first_tcp_fd >= 0) {
+        tcp_fds.push_back(first_tcp_fd);
+        while (tcp_fds.size() < count) {
+            int fd = create_tcp_listener(tcp_port);
+            if (fd < 0) {
+                errorHandler.handle_error("Transaction server failed to open a listener for event loop " + to_string(tcp_fds.size()) +
+                    " on TCP port " + to_string(tcp_port) + ": " + strerror(errno));
+                for (size_t i = 1; i < tcp_fds.size(); ++i) {
+                    close(tcp_fds[i]);
+                }
+                return false;
+            }
+            tcp_fds.push_back(fd);
+        }
+    }
+    running = true;
+    for (size_t i = 0; i < count; ++i) {
+        auto loop = make_unique<EventLoop>();
+        loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        loop->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        watch(loop->epoll_fd, loop->wake_fd, EPOLLIN);
+        if (!tcp_fds.empty()) {
+            loop->tcp_listen_fd = tcp_fds[i];
+            watch(loop->epoll_fd, loop->tcp_listen_fd, EPOLLIN);
+        }
+        if (unix_listen_fd >= 0) {
+            // Wake only one loop per incoming Unix connection
+            watch(loop->epoll_fd, unix_listen_fd, EPOLLIN | EPOLLEXCLUSIVE);
+        }
+        EventLoop& event_loop = *loop;
+        loops.push_back(move(loop));
+        event_loop.worker = thread([this, &event_loop] { run_loop(event_loop); });
+    }
+    return true;
+}
+
+void TransactionServer::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+    for (auto& loop : loops) {
+        uint64_t one = 1;
+        ssize_t ignored = write(loop->wake_fd, &one, sizeof(one));
+        (void)ignored;
+    }
+    for (auto& loop : loops) {
+        loop->worker.join();
+        close(loop->epoll_fd);
+        close(loop->wake_fd);
+        if (loop->tcp_listen_fd >= 0) {
+            close(loop->tcp_listen_fd);
+        }
+    }
+    loops.clear();
+    first_tcp_fd = -1;
+    if (unix_listen_fd >= 0) {
+        close(unix_listen_fd);
+        unix_listen_fd = -1;
+        unlink(unix_path.c_str());
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "error_handler.h"
+#include "system_call_interface.h"
+#include "wire_protocol.h"
+
+// TransactionServer class: non-blocking epoll front end. Each event loop
+// thread owns its own SO_REUSEPORT TCP listener, so the kernel spreads
+// connections across loops; the Unix socket listener is shared with
+// EPOLLEXCLUSIVE. A connection stays on the loop that accepted it.
+// Each wakeup reads at most MAX_READ bytes from a connection, and a
+// connection whose peer leaves more than OUT_HIGH_WATER bytes of responses
+// unread is not read from until they drain below OUT_LOW_WATER, so neither
+// buffer grows without bound. A peer that half-closes still gets every
+// response queued for it before the connection is closed.
+class TransactionServer {
+private:
+    struct Connection {
+        std::vector<char> in;
+        std::vector<char> out;
+        size_t out_offset = 0;
+        bool want_write = false;
+        bool reading = true;   // EPOLLIN armed; off while responses back up
+        bool draining = false; // Peer half-closed: send what is queued, then close
+    };
+
+    struct EventLoop {
+        int epoll_fd = -1;
+        int wake_fd = -1;
+        int tcp_listen_fd = -1;
+        std::thread worker;
+    };
+
+    static constexpr size_t READ_CHUNK = 64 * 1024;
+    static constexpr size_t MAX_READ = 4 * READ_CHUNK; // Per wakeup, so one connection cannot starve its loop
+    static constexpr size_t OUT_HIGH_WATER = 1024 * 1024;
+    static constexpr size_t OUT_LOW_WATER = 256 * 1024;
+    static constexpr size_t MAX_BATCH = 256; // Bounds how long one connection holds the account lock
+    static constexpr int MAX_EVENTS = 64;
+
+    SystemCallInterface& sysCallInterface;
+    ErrorHandler& errorHandler;
+    std::vector<std::unique_ptr<EventLoop>> loops;
+    int first_tcp_fd = -1; // Listener created by listen_tcp(), handed to loop 0
+    uint16_t tcp_port = 0;
+    int unix_listen_fd = -1;
+    std::string unix_path;
+    std::atomic<bool> running{ false };
+
+    int create_tcp_listener(uint16_t port);
+
+    bool watch(int epoll_fd, int fd, uint32_t events);
+
+    void accept_connections(EventLoop& loop, int listen_fd, std::unordered_map<int, Connection>& connections);
+
+    // Decode every complete pipelined frame (keyed ones with their key) in
+    // the input buffer, run them
+    // through the batch path (at most MAX_BATCH per account-lock acquisition)
+    // and append the responses to the output buffer, which is sent with one
+    // write once the whole read has been processed
+    void process_requests(Connection& connection);
+
+    // Read until the socket would block or MAX_READ bytes have been read.
+    // Returns false once the peer is gone.
+    bool read_requests(int fd, Connection& connection);
+
+    // Write queued responses; arm EPOLLOUT only while a backlog remains, and
+    // EPOLLIN only while the backlog is under the high-water mark
+    bool flush_responses(EventLoop& loop, int fd, Connection& connection);
+
+    void run_loop(EventLoop& loop);
+
+public:
+    TransactionServer(SystemCallInterface& sci, ErrorHandler& eh) : sysCallInterface(sci), errorHandler(eh) {}
+
+    ~TransactionServer();
+
+    // Listen on 127.0.0.1:port (0 picks an ephemeral port, see port())
+    bool listen_tcp(uint16_t port);
+
+    bool listen_unix(const std::string& path);
+
+    uint16_t port() const;
+
+    // Start one event loop thread per requested core; fails without
+    // starting any if a loop cannot get its own TCP listener
+    bool start(size_t num_loops);
+
+    void stop();
+};
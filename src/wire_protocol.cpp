@@ -0,0 +1,38 @@
+#include "wire_protocol.h"
+
+using namespace std;
+
+bool decode_request(const WireRequest& request, uint64_t idempotency_key, AccountManager::Operation& op) {
+    if ((request.flags & ~WIRE_FLAG_KEYED) != 0) {
+        return false;
+    }
+    switch (static_cast<WireOp>(request.op)) {
+    case WireOp::CreateAccount: op.type = AccountManager::Operation::CreateAccount; break;
+    case WireOp::Deposit: op.type = AccountManager::Operation::Deposit; break;
+    case WireOp::Withdraw: op.type = AccountManager::Operation::Withdraw; break;
+    case WireOp::CheckBalance: op.type = AccountManager::Operation::CheckBalance; break;
+    case WireOp::Transfer: op.type = AccountManager::Operation::Transfer; break;
+    default: return false;
+    }
+    op.account_id = request.arg1;
+    op.to_account_id = request.arg2;
+    op.amount = request.amount;
+    op.idempotency_key = idempotency_key;
+    return true;
+}
+
+WireResponse encode_response(const WireRequest& request, const AccountManager::Operation* op) {
+    WireResponse response{};
+    response.op = request.op;
+    response.request_id = request.request_id;
+    response.account_id = -1;
+    response.balance = -1.0f;
+    if (!op) {
+        response.status = static_cast<uint8_t>(WireStatus::BadRequest);
+        return response;
+    }
+    response.status = static_cast<uint8_t>(op->ok ? WireStatus::Ok : WireStatus::Failed);
+    response.account_id = op->result_account_id;
+    response.balance = op->balance;
+    return response;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+#include "account_manager.h"
+
+// Transaction Server Module
+// Compact binary protocol over TCP loopback or a Unix domain socket: fixed
+// size frames in host byte order. Clients may pipeline any number of
+// requests without waiting; every request gets exactly one response carrying
+// the same request_id, and responses come back in request order.
+// A request with WIRE_FLAG_KEYED set in `flags` is followed by an 8-byte
+// idempotency key, so a client can safely resend it after a lost response
+// (see SystemCallInterface); frames without the flag are unchanged.
+enum class WireOp : uint8_t {
+    CreateAccount = 1, // arg1 = customer_id, amount = initial balance
+    Deposit = 2,       // arg1 = account_id, amount
+    Withdraw = 3,      // arg1 = account_id, amount
+    CheckBalance = 4,  // arg1 = account_id
+    Transfer = 5,      // arg1 = source account_id, arg2 = destination account_id, amount
+};
+
+enum class WireStatus : uint8_t {
+    Ok = 0,
+    Failed = 1,     // Rejected by the system call interface (see errors.log)
+    BadRequest = 2, // Unknown operation or flags
+};
+
+constexpr uint8_t WIRE_FLAG_KEYED = 0x01;
+
+struct WireRequest {
+    uint8_t op;
+    uint8_t flags; // WIRE_FLAG_*; 0 from older clients
+    uint8_t reserved[2];
+    uint32_t request_id; // Chosen by the client, echoed in the response
+    int32_t arg1;
+    int32_t arg2;
+    float amount;
+};
+
+struct WireResponse {
+    uint8_t op;
+    uint8_t status;
+    uint8_t reserved[2];
+    uint32_t request_id;
+    int32_t account_id; // Created account ID for CreateAccount
+    float balance;      // Balance for CheckBalance
+};
+
+static_assert(sizeof(WireRequest) == 20, "WireRequest must stay 20 bytes on the wire");
+static_assert(sizeof(WireResponse) == 16, "WireResponse must stay 16 bytes on the wire");
+
+// Bytes a request occupies on the wire, including its key if it has one
+inline size_t wire_request_size(const WireRequest& request) {
+    return sizeof(WireRequest) + ((request.flags & WIRE_FLAG_KEYED) ? sizeof(uint64_t) : 0);
+}
+
+// Map a wire request and its idempotency key (0 for none) onto an
+// AccountManager batch operation; false for unknown ops or flags
+bool decode_request(const WireRequest& request, uint64_t idempotency_key, AccountManager::Operation& op);
+
+WireResponse encode_response(const WireRequest& request, const AccountManager::Operation* op);
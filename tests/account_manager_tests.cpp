@@ -0,0 +1,233 @@
+#include <atomic>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "account_manager.h"
+#include "logger.h"
+#include "test_harness.h"
+
+using namespace std;
+
+// Concurrency tests for AccountManager. Amounts are whole numbers well
+// below 2^24, so float balances stay exact and totals compare with ==.
+
+namespace {
+
+constexpr int THREADS = 4;
+
+// Success records would dominate the logs; audit records and errors stay
+void quiet(Logger& logger) {
+    logger.set_level(LogCategory::Transaction, LogLevel::Audit);
+}
+
+double total_balance(AccountManager& accounts, const vector<int>& ids) {
+    double total = 0.0;
+    for (int id : ids) {
+        total += accounts.check_balance(id);
+    }
+    return total;
+}
+
+// Move `amount` between two accounts through whichever path `kind` picks:
+// the locked transfer, an optimistic transaction or a posting
+void move_funds(AccountManager& accounts, int kind, int from, int to, float amount) {
+    switch (kind % 3) {
+    case 0:
+        accounts.transfer(from, to, amount);
+        break;
+    case 1:
+        accounts.transact({ from, to }, [amount](const vector<float>& balances, vector<float>& new_balances) {
+            if (balances[0] < amount) {
+                return false;
+            }
+            new_balances = { balances[0] - amount, balances[1] + amount };
+            return true;
+        });
+        break;
+    default:
+        accounts.post({ { from, -amount }, { to, amount } });
+        break;
+    }
+}
+
+}
+
+TEST_CASE(transfers_conserve_total) {
+    Logger logger;
+    quiet(logger);
+    // A single optimistic attempt sends conflicts to the locked fallback too
+    AccountManager accounts(logger, TransactionPolicy{ 1 });
+    constexpr int ACCOUNTS = 8;
+    constexpr float INITIAL = 1000.0f;
+    vector<int> ids;
+    for (int i = 0; i < ACCOUNTS; ++i) {
+        ids.push_back(accounts.add_account(i % 3, INITIAL));
+    }
+
+    vector<thread> workers;
+    for (int t = 0; t < THREADS; ++t) {
+        workers.emplace_back([&, t] {
+            mt19937 random(t);
+            for (int i = 0; i < 5000; ++i) {
+                int from = ids[random() % ACCOUNTS];
+                int to = ids[random() % ACCOUNTS];
+                if (from != to) {
+                    move_funds(accounts, i, from, to, static_cast<float>(1 + random() % 50));
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    CHECK(total_balance(accounts, ids) == ACCOUNTS * INITIAL);
+    CHECK(accounts.snapshot().total_balance == ACCOUNTS * INITIAL);
+    TransactionMetrics metrics = accounts.transaction_metrics();
+    CHECK(metrics.committed == metrics.optimistic_commits + metrics.locked_commits);
+    CHECK(metrics.optimistic_commits > 0);
+}
+
+TEST_CASE(hot_deposits_conserve_total) {
+    Logger logger;
+    quiet(logger);
+    AccountManager accounts(logger);
+    int hot = accounts.add_account(1, 0.0f);
+    int other = accounts.add_account(2, 0.0f);
+    CHECK(accounts.promote_hot(hot));
+
+    constexpr int DEPOSITS = 20000;
+    atomic<bool> depositing{ true };
+    atomic<int> withdrawn{ 0 };
+    vector<thread> depositors;
+    for (int t = 0; t < THREADS; ++t) {
+        depositors.emplace_back([&] {
+            for (int i = 0; i < DEPOSITS; ++i) {
+                CHECK(accounts.deposit(hot, 1.0f));
+            }
+        });
+    }
+    // Debits fold the stripes into the committed balance while they fill
+    thread debits([&] {
+        for (int i = 0; depositing.load(); ++i) {
+            if (accounts.withdraw(hot, 5.0f)) {
+                withdrawn.fetch_add(5);
+            }
+            move_funds(accounts, i, hot, other, 3.0f);
+            this_thread::yield();
+        }
+    });
+    for (auto& depositor : depositors) {
+        depositor.join();
+    }
+    depositing = false;
+    debits.join();
+
+    double expected = static_cast<double>(THREADS) * DEPOSITS - withdrawn.load();
+    CHECK(total_balance(accounts, { hot, other }) == expected);
+    CHECK(accounts.snapshot().total_balance == expected);
+}
+
+TEST_CASE(hot_deposit_racing_delete) {
+    Logger logger;
+    quiet(logger);
+    AccountManager accounts(logger);
+    for (int round = 0; round < 200; ++round) {
+        int id = accounts.add_account(round, 0.0f);
+        CHECK(accounts.promote_hot(id));
+        atomic<int> succeeded{ 0 };
+        atomic<int> started{ 0 };
+        vector<thread> depositors;
+        for (int t = 0; t < 2; ++t) {
+            depositors.emplace_back([&] {
+                started.fetch_add(1);
+                while (accounts.deposit(id, 1.0f)) {
+                    succeeded.fetch_add(1);
+                }
+            });
+        }
+        while (started.load() < 2 || succeeded.load() < 100) {
+            this_thread::yield();
+        }
+        CHECK(accounts.delete_account(id));
+        for (auto& depositor : depositors) {
+            depositor.join();
+        }
+
+        // Every deposit reported as made is in the balance the account closed with
+        float closing = -1.0f;
+        for (const string& record : logger.history(id)) {
+            size_t at = record.find("Closing Balance=");
+            if (record.find("Account deleted") != string::npos && at != string::npos) {
+                closing = stof(record.substr(at + 16));
+            }
+        }
+        CHECK(closing == static_cast<float>(succeeded.load()));
+        CHECK(!accounts.deposit(id, 1.0f));
+    }
+}
+
+TEST_CASE(snapshots_consistent_during_collect) {
+    Logger logger;
+    quiet(logger);
+    AccountManager accounts(logger);
+    constexpr int ACCOUNTS = 16;
+    constexpr float INITIAL = 500.0f;
+    vector<int> ids;
+    for (int i = 0; i < ACCOUNTS; ++i) {
+        ids.push_back(accounts.add_account(i % 4, INITIAL));
+    }
+    accounts.promote_hot(ids[0]);
+
+    atomic<bool> running{ true };
+    vector<thread> workers;
+    for (int t = 0; t < THREADS - 1; ++t) {
+        workers.emplace_back([&, t] {
+            mt19937 random(t);
+            while (running.load()) {
+                int from = ids[random() % ACCOUNTS];
+                int to = ids[random() % ACCOUNTS];
+                if (from != to) {
+                    move_funds(accounts, static_cast<int>(random()), from, to, static_cast<float>(1 + random() % 20));
+                }
+            }
+        });
+    }
+    // Versions are collected both here and by the writers as they commit
+    workers.emplace_back([&] {
+        while (running.load()) {
+            accounts.collect_garbage();
+            this_thread::yield();
+        }
+    });
+
+    for (int i = 0; i < 2000; ++i) {
+        AccountManager::BookSnapshot book = accounts.snapshot();
+        CHECK(book.accounts.size() == static_cast<size_t>(ACCOUNTS));
+        CHECK(book.total_balance == ACCOUNTS * INITIAL);
+        double balances = 0.0;
+        for (const auto& account : book.accounts) {
+            balances += account.balance;
+        }
+        CHECK(balances == book.total_balance);
+        // A customer's book is a snapshot of its own; it is not torn either
+        AccountManager::BookSnapshot customer = accounts.customer_book(i % 4);
+        CHECK(customer.accounts.size() == static_cast<size_t>(ACCOUNTS / 4));
+        double owned = 0.0;
+        for (const auto& account : customer.accounts) {
+            owned += account.balance;
+        }
+        CHECK(owned == customer.total_balance);
+        this_thread::yield();
+    }
+    running = false;
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    return run_tests(argc, argv);
+}
@@ -0,0 +1,60 @@
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <latch>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include "lock_monitor.h"
+#include "logger.h"
+#include "test_harness.h"
+
+using namespace std;
+
+// Deadlock detection tests. The policy is process-wide and must be set
+// before the locks are used, so these run in their own executable.
+
+TEST_CASE(two_lock_cycle_aborts_one_victim) {
+    Logger logger;
+    LockMonitor::set_logger(&logger);
+    LockMonitor::set_policy({ chrono::milliseconds(20), true });
+    MonitoredMutex first("TestFirst");
+    MonitoredMutex second("TestSecond");
+    latch both_holding(2);
+    atomic<int> aborted{ 0 };
+    atomic<int> acquired{ 0 };
+
+    // Each thread holds one lock and then asks for the other's
+    auto worker = [&](MonitoredMutex& mine, MonitoredMutex& theirs) {
+        lock_guard<MonitoredMutex> hold(mine);
+        both_holding.arrive_and_wait();
+        if (theirs.lock_or_abort()) {
+            acquired.fetch_add(1);
+            theirs.unlock();
+        }
+        else {
+            aborted.fetch_add(1);
+        }
+    };
+    uint64_t deadlocks_before = LockMonitor::deadlocks();
+    thread a(worker, ref(first), ref(second));
+    thread b(worker, ref(second), ref(first));
+    a.join();
+    b.join();
+    LockMonitor::set_logger(nullptr);
+    logger.flush();
+
+    CHECK(aborted.load() == 1);
+    CHECK(acquired.load() == 1);
+    CHECK(LockMonitor::deadlocks() == deadlocks_before + 1);
+    ifstream errors("errors.log");
+    stringstream text;
+    text << errors.rdbuf();
+    CHECK(text.str().find("Deadlock detected") != string::npos);
+    CHECK(text.str().find("aborted") != string::npos);
+}
+
+int main(int argc, char* argv[]) {
+    return run_tests(argc, argv);
+}
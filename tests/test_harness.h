@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+// A minimal test harness. TEST_CASE(name) registers a test; CHECK(cond)
+// records a failure without stopping the test, from any thread.
+// run_tests() runs every test (or those whose name contains the first
+// argument) in its own scratch directory, so the logs of one test do not
+// show up in another's history, and returns the process exit status. The
+// scratch directory is kept only if a test failed.
+struct TestCase {
+    const char* name;
+    void (*run)();
+};
+
+inline std::vector<TestCase>& test_cases() {
+    static std::vector<TestCase> cases;
+    return cases;
+}
+
+inline std::atomic<int>& check_failures() {
+    static std::atomic<int> failures{ 0 };
+    return failures;
+}
+
+struct TestRegistrar {
+    TestRegistrar(const char* name, void (*run)()) { test_cases().push_back({ name, run }); }
+};
+
+#define TEST_CASE(name)                                     \
+    static void name();                                     \
+    static TestRegistrar name##_registrar(#name, name);     \
+    static void name()
+
+#define CHECK(condition)                                                                        \
+    do {                                                                                        \
+        if (!(condition)) {                                                                     \
+            check_failures().fetch_add(1);                                                      \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #condition << std::endl; \
+        }                                                                                       \
+    } while (0)
+
+inline int run_tests(int argc, char* argv[]) {
+    std::string filter = argc > 1 ? argv[1] : "";
+    char scratch[] = "/tmp/banking-tests-XXXXXX";
+    if (!mkdtemp(scratch) || chdir(scratch) != 0) {
+        std::cerr << "Failed to create a scratch directory for test logs" << std::endl;
+        return 1;
+    }
+    int failed = 0;
+    for (const TestCase& test : test_cases()) {
+        if (std::string(test.name).find(filter) == std::string::npos) {
+            continue;
+        }
+        if ((mkdir(test.name, 0755) != 0 && errno != EEXIST) || chdir(test.name) != 0) {
+            std::cerr << "Failed to enter the scratch directory of " << test.name << std::endl;
+            return 1;
+        }
+        int before = check_failures().load();
+        test.run();
+        if (chdir(scratch) != 0) {
+            return 1;
+        }
+        bool ok = check_failures().load() == before;
+        failed += ok ? 0 : 1;
+        std::cout << (ok ? "[ OK ] " : "[FAIL] ") << test.name << std::endl;
+    }
+    if (failed > 0) {
+        std::cerr << "Logs kept in " << scratch << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::error_code ignored;
+    std::filesystem::remove_all(scratch, ignored);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,29 @@
+#!/bin/sh
+# Training workload for profile-guided optimization.
+# Usage: pgo_train.sh BIN_DIR
+# Runs the load generator in-process and over TCP against the server so both
+# the AccountManager hot paths and the epoll/wire protocol paths are profiled.
+set -eu
+
+bin_dir=${1:?usage: pgo_train.sh BIN_DIR}
+port=${BANKING_PGO_PORT:-17070}
+work_dir=$(mktemp -d)
+trap 'rm -rf "$work_dir"' EXIT
+cd "$work_dir"
+
+"$bin_dir/banking_loadgen" --target inproc --threads 4 --duration 3 --dist zipf
+"$bin_dir/banking_loadgen" --target inproc --threads 4 --duration 2 --loop open --rate 50000
+
+"$bin_dir/banking_server" --port "$port" --loops 2 &
+server_pid=$!
+sleep 1
+"$bin_dir/banking_loadgen" --target tcp --port "$port" --threads 4 --duration 3 --dist zipf
+kill -TERM "$server_pid"
+wait "$server_pid" || true
+
+# Clang writes raw profiles that have to be merged before the USE build
+case "${BANKING_COMPILER_ID:-}" in
+*Clang)
+    llvm-profdata merge -output="$BANKING_PGO_DIR/banking.profdata" "$BANKING_PGO_DIR"/*.profraw
+    ;;
+esac